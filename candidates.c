@@ -0,0 +1,103 @@
+#include "candidates.h"
+#include <pthread.h>
+
+// Числа таблицы в виде, удобном для векторизации: цифры упакованы по
+// полубайтам, набор цифр - битовой маской. Хвост после SECRET_SPACE
+// заполнен нулями и никогда не попадает в множество.
+static uint16_t packed_digits[CANDIDATE_WORDS * 64];
+static uint16_t digit_masks[CANDIDATE_WORDS * 64];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static uint16_t pack_digits(const int *number) {
+    return (uint16_t)(number[0] | number[1] << 4 | number[2] << 8 | number[3] << 12);
+}
+
+static void init_tables(void) {
+    for (int i = 0; i < SECRET_SPACE; i++) {
+        const int *number = secret_number(i);
+        packed_digits[i] = pack_digits(number);
+        digit_masks[i] = 0;
+        for (int k = 0; k < SECRET_LENGTH; k++) {
+            digit_masks[i] |= (uint16_t)(1 << number[k]);
+        }
+    }
+}
+
+void candidate_set_reset(CandidateSet *set) {
+    pthread_once(&tables_once, init_tables);
+
+    for (int w = 0; w < CANDIDATE_WORDS; w++) {
+        set->bits[w] = ~0ull;
+    }
+    if (SECRET_SPACE % 64) {
+        set->bits[CANDIDATE_WORDS - 1] = (1ull << (SECRET_SPACE % 64)) - 1;
+    }
+    set->count = SECRET_SPACE;
+}
+
+// Оставляет числа, для которых попытка guess дала бы тот же ответ.
+// Для чисел с уникальными цифрами это совпадает с calculate_bulls_cows:
+// быки - совпавшие позиции, коровы - общие цифры минус быки.
+int candidate_set_filter(CandidateSet *set, int *guess, int bulls, int cows) {
+    uint16_t code = pack_digits(guess);
+    int g0 = guess[0], g1 = guess[1], g2 = guess[2], g3 = guess[3];
+    int common = bulls + cows;
+    int count = 0;
+
+    for (int w = 0; w < CANDIDATE_WORDS; w++) {
+        if (set->bits[w] == 0) {
+            continue;
+        }
+
+        const uint16_t *digits = &packed_digits[w * 64];
+        const uint16_t *masks = &digit_masks[w * 64];
+        uint8_t match[64];
+
+        // Без ветвлений и с постоянными сдвигами - цикл векторизуется
+        for (int j = 0; j < 64; j++) {
+            unsigned x = digits[j] ^ code;
+            int b = ((x & 0x000F) == 0) + ((x & 0x00F0) == 0) +
+                    ((x & 0x0F00) == 0) + ((x & 0xF000) == 0);
+            int c = ((masks[j] >> g0) & 1) + ((masks[j] >> g1) & 1) +
+                    ((masks[j] >> g2) & 1) + ((masks[j] >> g3) & 1);
+            match[j] = (uint8_t)((b == bulls) & (c == common));
+        }
+
+        uint64_t keep = 0;
+        for (int j = 0; j < 64; j++) {
+            keep |= (uint64_t)match[j] << j;
+        }
+
+        set->bits[w] &= keep;
+        count += __builtin_popcountll(set->bits[w]);
+    }
+
+    set->count = count;
+    return count;
+}
+
+// Записывает n-е (с нуля) оставшееся число; 0 если такого нет
+int candidate_set_nth(CandidateSet *set, int n, int *secret) {
+    if (n < 0 || n >= set->count) {
+        return 0;
+    }
+
+    for (int w = 0; w < CANDIDATE_WORDS; w++) {
+        uint64_t bits = set->bits[w];
+        int ones = __builtin_popcountll(bits);
+
+        if (n >= ones) {
+            n -= ones;
+            continue;
+        }
+        while (n-- > 0) {
+            bits &= bits - 1;
+        }
+
+        int index = w * 64 + __builtin_ctzll(bits);
+        memcpy(secret, secret_number(index), sizeof(int) * SECRET_LENGTH);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef CANDIDATES_H
+#define CANDIDATES_H
+
+#include "common.h"
+
+#define CANDIDATE_WORDS ((SECRET_SPACE + 63) / 64)
+
+// Множество чисел, ещё совместимых с ответами на попытки игрока.
+// Бит i соответствует числу secret_number(i).
+typedef struct {
+    uint64_t bits[CANDIDATE_WORDS];
+    int count;
+} CandidateSet;
+
+void candidate_set_reset(CandidateSet *set);
+int candidate_set_filter(CandidateSet *set, int *guess, int bulls, int cows);
+int candidate_set_nth(CandidateSet *set, int n, int *secret);
+
+#endif // CANDIDATES_H
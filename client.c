@@ -30,7 +30,8 @@ void print_menu() {
     printf("2. Присоединиться к игре по имени\n");
     printf("3. Найти доступную игру (автопоиск)\n");
     printf("4. Список активных игр\n");
-    printf("5. Выход\n");
+    printf("5. Таблица лидеров\n");
+    printf("6. Выход\n");
     printf("========================================\n");
     printf("Выберите действие: ");
 }
@@ -53,17 +54,19 @@ void print_game_rules() {
     printf("========================================\n\n");
 }
 
-int read_number(int *number) {
-    char input[100];
-    printf("Введите 4-значное число: ");
+int read_input(char *input, size_t size) {
+    printf("Введите 4-значное число ('h' - подсказка, 's' - состояние игры, 'q' - выход): ");
     
-    if (fgets(input, sizeof(input), stdin) == NULL) {
+    if (fgets(input, (int)size, stdin) == NULL) {
         return 0;
     }
     
     // Удаляем перевод строки
     input[strcspn(input, "\n")] = 0;
-    
+    return 1;
+}
+
+int parse_number(const char *input, int *number) {
     if (strlen(input) != SECRET_LENGTH) {
         printf("Ошибка: нужно ввести ровно %d цифры\n", SECRET_LENGTH);
         return 0;
@@ -195,6 +198,109 @@ void list_games(void *socket) {
     printf("\nАктивных игр на сервере: %d\n", response.game_count);
 }
 
+void print_player_stats(PlayerStats *stats) {
+    printf("%-20s побед: %4d  игр: %4d", stats->name, stats->wins, stats->games);
+    if (stats->wins > 0) {
+        printf("  ср. попыток: %.2f", (double)stats->win_attempts / stats->wins);
+    }
+    printf("\n");
+}
+
+void show_leaderboard(void *socket, const char *player_name) {
+    Message request, response;
+    init_message(&request);
+    
+    request.type = MSG_GET_LEADERBOARD;
+    strcpy(request.player_name, player_name);
+    
+    send_message_dealer(socket, &request);
+    recv_message_dealer(socket, &response);
+    
+    if (response.type == MSG_ERROR) {
+        printf("Ошибка: %s\n", response.error_msg);
+        return;
+    }
+    
+    printf("\n========== Таблица лидеров ==========\n");
+    if (response.player_count == 0) {
+        printf("Пока никто не выигрывал\n");
+    }
+    for (int i = 0; i < response.player_count; i++) {
+        printf("%2d. ", i + 1);
+        print_player_stats(&response.leaders[i]);
+    }
+    printf("\nВаша статистика:\n    ");
+    print_player_stats(&response.stats);
+}
+
+void show_hint(void *socket, const char *player_name, const char *game_name) {
+    Message request, response;
+    init_message(&request);
+    
+    request.type = MSG_GET_HINT;
+    strcpy(request.player_name, player_name);
+    strcpy(request.game_name, game_name);
+    
+    send_message_dealer(socket, &request);
+    recv_message_dealer(socket, &response);
+    
+    if (response.type == MSG_ERROR) {
+        printf("Ошибка: %s\n", response.error_msg);
+        return;
+    }
+    
+    printf("Подсказка: возможных чисел осталось %d", response.candidates_left);
+    if (response.candidates_left > 0) {
+        printf(", попробуйте %d%d%d%d", response.guess[0], response.guess[1],
+               response.guess[2], response.guess[3]);
+    }
+    printf("\n");
+}
+
+void leave_game(void *socket, const char *player_name, const char *game_name) {
+    Message request, response;
+    init_message(&request);
+    
+    request.type = MSG_LEAVE_GAME;
+    strcpy(request.player_name, player_name);
+    strcpy(request.game_name, game_name);
+    
+    send_message_dealer(socket, &request);
+    recv_message_dealer(socket, &response);
+    
+    if (response.type == MSG_ERROR) {
+        printf("Ошибка: %s\n", response.error_msg);
+        return;
+    }
+    
+    printf("Вы покинули игру '%s'\n", response.game_name);
+}
+
+void show_game_state(void *socket, const char *game_name) {
+    Message request, response;
+    init_message(&request);
+    
+    request.type = MSG_GAME_STATE;
+    strcpy(request.game_name, game_name);
+    
+    send_message_dealer(socket, &request);
+    recv_message_dealer(socket, &response);
+    
+    if (response.type == MSG_ERROR) {
+        printf("Ошибка: %s\n", response.error_msg);
+        return;
+    }
+    
+    printf("\nИгра '%s': игроков %d/%d\n", response.game_name,
+           response.player_count, response.max_players);
+    for (int i = 0; i < response.player_count; i++) {
+        printf("  %-20s попыток: %d\n", response.players[i].name, response.players[i].attempts);
+    }
+    if (response.is_winner) {
+        printf("Игра завершена. Победитель: %s\n", response.winner);
+    }
+}
+
 void play_game(void *socket, const char *player_name, const char *game_name) {
     print_game_rules();
     
@@ -214,7 +320,26 @@ void play_game(void *socket, const char *player_name, const char *game_name) {
         strcpy(request.player_name, player_name);
         strcpy(request.game_name, game_name);
         
-        if (!read_number(request.guess)) {
+        if (!read_input(input, sizeof(input))) {
+            break;
+        }
+        
+        if (strcmp(input, "q") == 0) {
+            leave_game(socket, player_name, game_name);
+            break;
+        }
+        
+        if (strcmp(input, "h") == 0) {
+            show_hint(socket, player_name, game_name);
+            continue;
+        }
+        
+        if (strcmp(input, "s") == 0) {
+            show_game_state(socket, game_name);
+            continue;
+        }
+        
+        if (!parse_number(input, request.guess)) {
             printf("Попробуйте снова\n");
             continue;
         }
@@ -272,6 +397,14 @@ int main() {
     void *context = zmq_ctx_new();
     void *socket = zmq_socket(context, ZMQ_DEALER);
     
+#ifdef ZMQ_HEARTBEAT_IVL
+    // Пинги позволяют обнаружить пропавший сервер
+    int heartbeat_ivl = 5000;
+    int heartbeat_timeout = 15000;
+    zmq_setsockopt(socket, ZMQ_HEARTBEAT_IVL, &heartbeat_ivl, sizeof(heartbeat_ivl));
+    zmq_setsockopt(socket, ZMQ_HEARTBEAT_TIMEOUT, &heartbeat_timeout, sizeof(heartbeat_timeout));
+#endif
+    
     int rc = zmq_connect(socket, SERVER_ENDPOINT);
     if (rc != 0) {
         printf("Ошибка подключения к серверу: %s\n", zmq_strerror(errno));
@@ -305,6 +438,9 @@ int main() {
                 list_games(socket);
                 break;
             case 5:
+                show_leaderboard(socket, player_name);
+                break;
+            case 6:
                 printf("\nДо свидания!\n");
                 zmq_close(socket);
                 zmq_ctx_destroy(context);
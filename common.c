@@ -1,4 +1,6 @@
 #include "common.h"
+#include "prng.h"
+#include <pthread.h>
 
 void init_message(Message *msg) {
     memset(msg, 0, sizeof(Message));
@@ -14,21 +16,45 @@ int recv_message(void *socket, Message *msg) {
     return rc;
 }
 
-void generate_secret(int *secret) {
-    int used[10] = {0};
-    srand(time(NULL) ^ (unsigned int)(uintptr_t)secret);
+// Все допустимые секреты в лексикографическом порядке. Одна таблица на
+// процесс: из неё выбираются секреты и по ней нумеруются кандидаты.
+static int secret_table[SECRET_SPACE][SECRET_LENGTH];
+static pthread_once_t secret_table_once = PTHREAD_ONCE_INIT;
+
+static void build_secret_table(void) {
+    int count = 0;
     
-    for (int i = 0; i < SECRET_LENGTH; i++) {
-        int digit;
-        do {
-            digit = rand() % 10;
-        } while (used[digit]);
-        
-        used[digit] = 1;
-        secret[i] = digit;
+    for (int a = 0; a < 10; a++) {
+        for (int b = 0; b < 10; b++) {
+            if (b == a) continue;
+            for (int c = 0; c < 10; c++) {
+                if (c == a || c == b) continue;
+                for (int d = 0; d < 10; d++) {
+                    if (d == a || d == b || d == c) continue;
+                    secret_table[count][0] = a;
+                    secret_table[count][1] = b;
+                    secret_table[count][2] = c;
+                    secret_table[count][3] = d;
+                    count++;
+                }
+            }
+        }
     }
 }
 
+// Число с номером index (0 <= index < SECRET_SPACE) из таблицы секретов
+const int *secret_number(int index) {
+    pthread_once(&secret_table_once, build_secret_table);
+    return secret_table[index];
+}
+
+void generate_secret(int *secret) {
+    // Генератор у каждого потока свой: без общей блокировки libc и без
+    // одинаковых секретов у игр, созданных в одну секунду
+    int index = prng_below(prng_local(), SECRET_SPACE);
+    memcpy(secret, secret_number(index), sizeof(int) * SECRET_LENGTH);
+}
+
 void calculate_bulls_cows(int *secret, int *guess, int *bulls, int *cows) {
     *bulls = 0;
     *cows = 0;
@@ -11,8 +11,11 @@
 #define MAX_GAME_NAME 64
 #define MAX_PLAYER_NAME 32
 #define MAX_PLAYERS 10
+#define MAX_GAMES 100
 #define SECRET_LENGTH 4
 #define MAX_ATTEMPTS 100
+#define LEADERBOARD_SIZE 10
+#define SECRET_SPACE 5040 // 10 * 9 * 8 * 7 чисел с уникальными цифрами
 
 // Типы сообщений
 typedef enum {
@@ -22,6 +25,8 @@ typedef enum {
     MSG_MAKE_GUESS,
     MSG_LEAVE_GAME,
     MSG_LIST_GAMES,
+    MSG_GET_LEADERBOARD,
+    MSG_GET_HINT,
     
     // Ответы сервера
     MSG_GAME_CREATED,
@@ -31,7 +36,10 @@ typedef enum {
     MSG_GAME_WON,
     MSG_GAME_STATE,
     MSG_ERROR,
-    MSG_GAME_LIST
+    MSG_GAME_LIST,
+    MSG_LEADERBOARD,
+    MSG_HINT,
+    MSG_LEFT_GAME
 } MessageType;
 
 // Структура для результата попытки
@@ -42,18 +50,37 @@ typedef struct {
     char player_name[MAX_PLAYER_NAME];
 } GuessResult;
 
+// Игрок в снимке состояния игры
+typedef struct {
+    char name[MAX_PLAYER_NAME];
+    int attempts;
+} PlayerInfo;
+
+// Статистика игрока по всем играм
+typedef struct {
+    char name[MAX_PLAYER_NAME];
+    int wins;
+    int games;
+    int win_attempts;   // сумма попыток в выигранных играх
+} PlayerStats;
+
 // Структура сообщения
 typedef struct {
     MessageType type;
     char game_name[MAX_GAME_NAME];
     char player_name[MAX_PLAYER_NAME];
     int max_players;
-    int guess[SECRET_LENGTH];
+    int guess[SECRET_LENGTH];         // в MSG_HINT - предлагаемая попытка
+    int candidates_left;              // сколько чисел ещё возможно
     GuessResult result;
     char error_msg[256];
     int game_count;
     int player_count;
     int is_winner;
+    PlayerStats stats;                        // статистика запросившего игрока
+    PlayerStats leaders[LEADERBOARD_SIZE];    // лучшие игроки, player_count записей
+    char winner[MAX_PLAYER_NAME];             // MSG_GAME_STATE: победитель, если is_winner
+    PlayerInfo players[MAX_PLAYERS];          // MSG_GAME_STATE: player_count игроков
 } Message;
 
 // Функции для работы с сообщениями
@@ -65,5 +92,17 @@ int recv_message(void *socket, Message *msg);
 void generate_secret(int *secret);
 void calculate_bulls_cows(int *secret, int *guess, int *bulls, int *cows);
 int is_valid_number(int *number);
+const int *secret_number(int index);
+
+// FNV-1a хеш строки, не дальше max_len байт: имена из сообщений
+// могут прийти без завершающего нуля
+static inline uint32_t hash_name(const char *name, size_t max_len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < max_len && name[i]; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
 
 #endif // COMMON_H
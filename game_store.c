@@ -0,0 +1,145 @@
+#include "game_store.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Время запуска процесса в тактах от загрузки системы (поле 22
+// /proc/<pid>/stat); 0 - процесса нет
+static uint64_t process_start_time(int pid) {
+    char path[64], stat[512];
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t n = read(fd, stat, sizeof(stat) - 1);
+    close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+    stat[n] = '\0';
+
+    // Имя процесса в скобках может содержать пробелы, поля считаем после него
+    char *p = strrchr(stat, ')');
+    for (int field = 2; p && field < 22; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    return p ? strtoull(p + 1, NULL, 10) : 0;
+}
+
+// Жив ли процесс pid. При start != 0 это должен быть тот же процесс,
+// что записал себя владельцем, а не новый с тем же pid.
+static int process_alive(int pid, uint64_t start) {
+    if (pid <= 0 || pid == getpid()) {
+        return 0;
+    }
+    if (start != 0) {
+        return process_start_time(pid) == start;
+    }
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// Записывает текущий процесс владельцем сегмента
+void game_store_set_owner(GameStore *store) {
+    atomic_store(&store->header.owner_start, process_start_time(getpid()));
+    atomic_store(&store->header.owner_pid, getpid());
+}
+
+// Проверяет, что сегмент создан совместимой сборкой
+static int store_compatible(GameStore *store) {
+    GameStoreHeader *header = &store->header;
+
+    return atomic_load_explicit(&header->magic, memory_order_acquire) == GAME_STORE_MAGIC &&
+           header->version == GAME_STORE_VERSION &&
+           header->table_size == sizeof(GameTable);
+}
+
+// Подключается к сегменту или создаёт новый. В previous_owner - pid
+// живого процесса, который обслуживает эти игры сейчас, иначе 0.
+GameStore *game_store_attach(const char *name, int *previous_owner) {
+    *previous_owner = 0;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int created = 1;
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            created = 0;
+            fd = shm_open(name, O_RDWR, 0);
+        }
+        if (fd < 0) {
+            printf("Ошибка shm_open %s: %s\n", name, strerror(errno));
+            return NULL;
+        }
+
+        struct stat st;
+        if (created && ftruncate(fd, sizeof(GameStore)) != 0) {
+            printf("Ошибка ftruncate %s: %s\n", name, strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return NULL;
+        }
+
+        size_t size = (size_t)st.st_size;
+        GameStore *store = NULL;
+        if (size >= sizeof(GameStoreHeader)) {
+            store = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (store == MAP_FAILED) {
+            printf("Ошибка mmap %s: %s\n", name, strerror(errno));
+            return NULL;
+        }
+
+        if (created) {
+            // Страницы сегмента уже обнулены, magic пишется последним
+            game_table_init(&store->table, TABLE_PROCESSES);
+            store->header.version = GAME_STORE_VERSION;
+            store->header.table_size = sizeof(GameTable);
+            game_store_set_owner(store);
+            atomic_store_explicit(&store->header.magic, GAME_STORE_MAGIC, memory_order_release);
+            printf("Создан сегмент игр %s\n", name);
+            return store;
+        }
+
+        if (store && size == sizeof(GameStore) && store_compatible(store)) {
+            int owner = atomic_load(&store->header.owner_pid);
+            if (process_alive(owner, atomic_load(&store->header.owner_start))) {
+                *previous_owner = owner;
+            }
+            printf("Подключен сегмент игр %s: %d игр\n", name, atomic_load(&store->table.game_count));
+            return store;
+        }
+
+        // Сегмент другой версии: занимать его нельзя, пока жив владелец.
+        // Смещение owner_pid во всех версиях одно, времени запуска может
+        // не быть - тогда проверяем только pid, сигнал тут не шлём.
+        int owner = store ? atomic_load(&store->header.owner_pid) : 0;
+        if (store) {
+            munmap(store, size);
+        }
+        if (process_alive(owner, 0)) {
+            printf("Сегмент %s другой версии используется процессом %d\n", name, owner);
+            return NULL;
+        }
+        printf("Сегмент %s другой версии, создаём заново\n", name);
+        shm_unlink(name);
+    }
+
+    return NULL;
+}
+
+// Отключается от сегмента; remove - удалить его (игры больше не нужны)
+void game_store_detach(GameStore *store, const char *name, int remove) {
+    if (remove) {
+        pthread_mutex_destroy(&store->table.mutex);
+        shm_unlink(name);
+    }
+    munmap(store, sizeof(GameStore));
+}
@@ -0,0 +1,32 @@
+#ifndef GAME_STORE_H
+#define GAME_STORE_H
+
+#include "server.h"
+
+// Таблица игр в именованной разделяемой памяти (shm_open). Новый процесс
+// сервера подключается к сегменту прежнего и продолжает обслуживать те же
+// игры без сериализации: прежний процесс дообрабатывает запросы и
+// освобождает endpoint.
+#define GAME_STORE_NAME "/bulls_cows_games"
+#define GAME_STORE_MAGIC 0x53474342u    // "BCGS"
+#define GAME_STORE_VERSION 2            // менять при любом изменении Game/GameTable
+
+typedef struct {
+    atomic_uint magic;          // записывается последним, после инициализации
+    uint32_t version;
+    uint64_t table_size;        // sizeof(GameTable) создавшей сегмент сборки
+    atomic_int owner_pid;       // процесс, который сейчас обслуживает endpoint
+    _Atomic uint64_t owner_start;   // время его запуска: pid после сбоя мог
+                                    // достаться другому процессу
+} GameStoreHeader;
+
+typedef struct {
+    GameStoreHeader header;
+    GameTable table;
+} GameStore;
+
+GameStore *game_store_attach(const char *name, int *previous_owner);
+void game_store_set_owner(GameStore *store);
+void game_store_detach(GameStore *store, const char *name, int remove);
+
+#endif // GAME_STORE_H
@@ -0,0 +1,366 @@
+#define _GNU_SOURCE
+#include "gateway.h"
+#include "profile.h"
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define GATEWAY_EVENTS 256
+#define GATEWAY_BATCH 32        // ответов за один writev
+#define GATEWAY_OUT_FRAMES 16   // неотправленных ответов до отключения клиента
+#define GATEWAY_BIND_RETRY_MS 5000
+#define GATEWAY_FLUSH_MS 200    // сколько досылаем ответы при остановке
+
+// Состояние соединения. Входной буфер вмещает ровно один кадр, выходной
+// выделяется только когда сокет не принял ответ целиком.
+typedef struct Connection {
+    int fd;
+    size_t received;            // байт текущего кадра в frame
+    char *out;
+    size_t out_start;
+    size_t out_len;
+    struct Connection *prev;
+    struct Connection *next;
+    GatewayFrame frame;
+} Connection;
+
+static GameTable *gateway_table = NULL;
+static int listen_fd = -1;
+static int epoll_fd = -1;
+static pthread_t gateway_tid;
+static Connection *connections = NULL;
+
+// Ответы текущей пачки; шлюз работает в одном потоке
+static uint32_t reply_lengths[GATEWAY_BATCH];
+static Message replies[GATEWAY_BATCH];
+static int reply_count = 0;
+
+static void close_connection(Connection *conn) {
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        connections = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    }
+
+    // Неотправленные ответы закрываемого соединения отбрасываются
+    reply_count = 0;
+    close(conn->fd);
+    free(conn->out);
+    free(conn);
+}
+
+// Дописывает байты в выходной буфер; 0 - клиент не успевает читать ответы
+static int queue_output(Connection *conn, const char *data, size_t size) {
+    size_t capacity = GATEWAY_OUT_FRAMES * sizeof(GatewayFrame);
+
+    if (!conn->out) {
+        conn->out = malloc(capacity);
+        if (!conn->out) {
+            return 0;
+        }
+    }
+    if (conn->out_start > 0) {
+        memmove(conn->out, conn->out + conn->out_start, conn->out_len);
+        conn->out_start = 0;
+    }
+    if (conn->out_len + size > capacity) {
+        return 0;
+    }
+
+    memcpy(conn->out + conn->out_len, data, size);
+    conn->out_len += size;
+    return 1;
+}
+
+// Отправляет накопленный выходной буфер; 0 - соединение нужно закрыть
+static int flush_output(Connection *conn) {
+    while (conn->out_len > 0) {
+        ssize_t n = write(conn->fd, conn->out + conn->out_start, conn->out_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN;
+        }
+        conn->out_start += n;
+        conn->out_len -= n;
+    }
+
+    // Буфер больше не нужен, пока сокет успевает
+    free(conn->out);
+    conn->out = NULL;
+    conn->out_start = 0;
+    return 1;
+}
+
+// Отправляет пачку ответов одним writev; 0 - соединение нужно закрыть
+static int send_replies(Connection *conn) {
+    struct iovec iov[GATEWAY_BATCH * 2];
+    int count = reply_count;
+
+    reply_count = 0;
+    if (count == 0) {
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        iov[i * 2].iov_base = &reply_lengths[i];
+        iov[i * 2].iov_len = sizeof(uint32_t);
+        iov[i * 2 + 1].iov_base = &replies[i];
+        iov[i * 2 + 1].iov_len = sizeof(Message);
+    }
+
+    int first = 0;
+    if (conn->out_len == 0) {
+        ssize_t n;
+        do {
+            n = writev(conn->fd, iov, count * 2);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && errno != EAGAIN) {
+            return 0;
+        }
+
+        // Пропускаем отправленное, остаток уходит в выходной буфер
+        size_t written = n > 0 ? (size_t)n : 0;
+        while (first < count * 2 && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (first < count * 2) {
+            iov[first].iov_base = (char*)iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+
+    for (int i = first; i < count * 2; i++) {
+        if (!queue_output(conn, iov[i].iov_base, iov[i].iov_len)) {
+            printf("Шлюз: клиент не читает ответы, соединение закрыто\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void accept_connections(void) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN) {
+                printf("Шлюз: ошибка accept: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection *conn = malloc(sizeof(Connection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->received = 0;
+        conn->out = NULL;
+        conn->out_start = 0;
+        conn->out_len = 0;
+        conn->prev = NULL;
+        conn->next = connections;
+        if (connections) {
+            connections->prev = conn;
+        }
+        connections = conn;
+
+        // Edge-triggered: читаем и пишем до EAGAIN при каждом событии
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = conn;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close_connection(conn);
+        }
+    }
+}
+
+// Читает все доступные кадры; 0 - соединение нужно закрыть
+static int read_requests(Connection *conn) {
+    for (;;) {
+        ssize_t n = read(conn->fd, (char*)&conn->frame + conn->received,
+                         sizeof(GatewayFrame) - conn->received);
+        if (n == 0) {
+            send_replies(conn);
+            return 0;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) {
+                return 0;
+            }
+            return send_replies(conn);
+        }
+
+        size_t before = conn->received;
+        conn->received += n;
+
+        // Кадры фиксированной длины, другая длина - не наш протокол
+        if (before < sizeof(uint32_t) && conn->received >= sizeof(uint32_t) &&
+            ntohl(conn->frame.length) != sizeof(Message)) {
+            printf("Шлюз: кадр неверной длины: %u байт\n", ntohl(conn->frame.length));
+            return 0;
+        }
+        if (conn->received < sizeof(GatewayFrame)) {
+            continue;
+        }
+
+        PROF_BEGIN(conn->frame.body.type);
+        PROF_TIMESTAMP(t_handler);
+        process_message(gateway_table, &conn->frame.body, &replies[reply_count]);
+        PROF_RECORD(PROF_HANDLER, t_handler);
+        reply_lengths[reply_count] = htonl(sizeof(Message));
+        reply_count++;
+        conn->received = 0;
+
+        if (reply_count == GATEWAY_BATCH && !send_replies(conn)) {
+            return 0;
+        }
+    }
+}
+
+static void* gateway_thread(void *arg) {
+    (void)arg;
+    struct epoll_event events[GATEWAY_EVENTS];
+
+    while (running) {
+        int count = epoll_wait(epoll_fd, events, GATEWAY_EVENTS, 1000);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            printf("Шлюз: ошибка epoll_wait: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Connection *conn = events[i].data.ptr;
+            if (!conn) {
+                accept_connections();
+                continue;
+            }
+
+            int alive = !(events[i].events & EPOLLERR);
+            if (alive && (events[i].events & EPOLLOUT)) {
+                alive = flush_output(conn);
+            }
+            if (alive && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+                alive = read_requests(conn);
+            }
+            if (!alive) {
+                close_connection(conn);
+            }
+        }
+    }
+
+    PROF_THREAD_EXIT();
+    return NULL;
+}
+
+// Запускает шлюз в отдельном потоке; запросы идут в ту же таблицу игр.
+// wait_port - порт ещё держит прежний процесс (передача управления).
+int gateway_start(GameTable *table, int port, int wait_port) {
+    struct sockaddr_in addr;
+    struct rlimit limit;
+    int one = 1;
+
+    // Каждое соединение - дескриптор, мягкого лимита по умолчанию мало
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        printf("Шлюз: ошибка создания сокета: %s\n", strerror(errno));
+        return -1;
+    }
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    // Прежний процесс освобождает порт, когда дообработает запросы
+    int rc, waited = 0;
+    while ((rc = bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr))) != 0 &&
+           errno == EADDRINUSE && wait_port && waited < GATEWAY_BIND_RETRY_MS) {
+        usleep(10000);
+        waited += 10;
+    }
+    if (rc != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        printf("Шлюз: ошибка привязки к порту %d: %s\n", port, strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = NULL;
+    if (epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+        printf("Шлюз: ошибка epoll: %s\n", strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    gateway_table = table;
+    if (pthread_create(&gateway_tid, NULL, gateway_thread, NULL) != 0) {
+        printf("Шлюз: ошибка создания потока\n");
+        close(epoll_fd);
+        close(listen_fd);
+        return -1;
+    }
+
+    printf("TCP-шлюз запущен на порту %d\n", port);
+    return 0;
+}
+
+// Досылает ответы из выходных буферов, не дольше GATEWAY_FLUSH_MS.
+// Поток шлюза к этому моменту завершён, все прочитанные запросы отвечены.
+static void flush_pending(void) {
+    struct epoll_event events[GATEWAY_EVENTS];
+    long start = monotonic_ms();
+
+    for (;;) {
+        int pending = 0;
+        for (Connection *conn = connections; conn; conn = conn->next) {
+            if (conn->out_len == 0) {
+                continue;
+            }
+            if (!flush_output(conn)) {
+                conn->out_len = 0;
+            } else if (conn->out_len > 0) {
+                pending++;
+            }
+        }
+        if (pending == 0 || monotonic_ms() - start >= GATEWAY_FLUSH_MS) {
+            return;
+        }
+        epoll_wait(epoll_fd, events, GATEWAY_EVENTS, 10);
+    }
+}
+
+// Ждёт завершения потока шлюза (после сброса running), досылает ответы
+// и закрывает соединения. Клиенты шлюза после этого переподключаются.
+void gateway_stop(void) {
+    pthread_join(gateway_tid, NULL);
+
+    flush_pending();
+    while (connections) {
+        close_connection(connections);
+    }
+    close(epoll_fd);
+    close(listen_fd);
+}
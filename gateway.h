@@ -0,0 +1,22 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include "server.h"
+#include <stddef.h>
+
+// TCP-шлюз для клиентов без ZeroMQ. Кадр в обе стороны - 4 байта длины
+// в сетевом порядке и следом структура Message, как в сокете ROUTER.
+#define GATEWAY_PORT 5556
+
+typedef struct {
+    uint32_t length;    // htonl(sizeof(Message))
+    Message body;
+} GatewayFrame;
+
+_Static_assert(offsetof(GatewayFrame, body) == sizeof(uint32_t),
+               "между длиной и телом кадра не должно быть выравнивания");
+
+int gateway_start(GameTable *table, int port, int wait_port);
+void gateway_stop(void);
+
+#endif // GATEWAY_H
@@ -0,0 +1,249 @@
+#include "gateway.h"
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// Сравнение TCP-шлюза и пути через ROUTER: память сервера на одно
+// соединение и задержка запроса при большом числе подключений.
+//
+//   gateway_bench <tcp|zmq> <соединений> <раундов> [pid сервера]
+//
+// Запросы - MSG_GAME_STATE несуществующей игры, он не меняет таблицу
+// и не печатает в лог, поэтому измеряется сам транспорт.
+
+#define ROUTER_ENDPOINT "tcp://localhost:5555"
+
+typedef struct {
+    int use_tcp;
+    int count;
+    int *fds;
+    void *context;
+    void **sockets;
+} BenchClients;
+
+// Резидентная память процесса в КБ, -1 если pid не задан
+long read_rss(int pid) {
+    char path[64], line[256];
+    long rss = -1;
+
+    if (pid <= 0) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "VmRSS: %ld", &rss) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return rss;
+}
+
+int tcp_connect(void) {
+    struct sockaddr_in addr;
+    int one = 1;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(GATEWAY_PORT);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int tcp_transfer(int fd, void *data, size_t size, int send_data) {
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = send_data ? write(fd, (char*)data + done, size - done)
+                              : read(fd, (char*)data + done, size - done);
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+// Один запрос и ожидание ответа на соединении index
+int round_trip(BenchClients *clients, int index, GatewayFrame *frame) {
+    if (clients->use_tcp) {
+        int fd = clients->fds[index];
+        frame->length = htonl(sizeof(Message));
+        if (tcp_transfer(fd, frame, sizeof(GatewayFrame), 1) != 0 ||
+            tcp_transfer(fd, frame, sizeof(GatewayFrame), 0) != 0) {
+            return -1;
+        }
+        return 0;
+    }
+
+    void *socket = clients->sockets[index];
+    char delimiter[10];
+    zmq_send(socket, "", 0, ZMQ_SNDMORE);
+    zmq_send(socket, &frame->body, sizeof(Message), 0);
+    zmq_recv(socket, delimiter, sizeof(delimiter), 0);
+    return zmq_recv(socket, &frame->body, sizeof(Message), 0) == sizeof(Message) ? 0 : -1;
+}
+
+int open_clients(BenchClients *clients) {
+    if (clients->use_tcp) {
+        clients->fds = calloc(clients->count, sizeof(int));
+        for (int i = 0; i < clients->count; i++) {
+            if ((clients->fds[i] = tcp_connect()) < 0) {
+                printf("Не удалось подключиться к шлюзу (%d): %s\n", i, strerror(errno));
+                return i;
+            }
+        }
+        return clients->count;
+    }
+
+    clients->context = zmq_ctx_new();
+    zmq_ctx_set(clients->context, ZMQ_MAX_SOCKETS, clients->count + 16);
+    clients->sockets = calloc(clients->count, sizeof(void*));
+    for (int i = 0; i < clients->count; i++) {
+        clients->sockets[i] = zmq_socket(clients->context, ZMQ_DEALER);
+        if (!clients->sockets[i] || zmq_connect(clients->sockets[i], ROUTER_ENDPOINT) != 0) {
+            printf("Не удалось создать сокет (%d): %s\n", i, zmq_strerror(zmq_errno()));
+            return i;
+        }
+    }
+    return clients->count;
+}
+
+void close_clients(BenchClients *clients, int opened) {
+    for (int i = 0; i < opened; i++) {
+        if (clients->use_tcp) {
+            close(clients->fds[i]);
+        } else {
+            int linger = 0;
+            zmq_setsockopt(clients->sockets[i], ZMQ_LINGER, &linger, sizeof(linger));
+            zmq_close(clients->sockets[i]);
+        }
+    }
+    if (clients->context) {
+        zmq_ctx_destroy(clients->context);
+    }
+    free(clients->fds);
+    free(clients->sockets);
+}
+
+int compare_long(const void *a, const void *b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+long elapsed_ns(struct timespec *begin, struct timespec *end) {
+    return (end->tv_sec - begin->tv_sec) * 1000000000L + (end->tv_nsec - begin->tv_nsec);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4 || (strcmp(argv[1], "tcp") != 0 && strcmp(argv[1], "zmq") != 0)) {
+        printf("Использование: %s <tcp|zmq> <соединений> <раундов> [pid сервера]\n", argv[0]);
+        return 1;
+    }
+
+    BenchClients clients;
+    memset(&clients, 0, sizeof(clients));
+    clients.use_tcp = strcmp(argv[1], "tcp") == 0;
+    clients.count = atoi(argv[2]);
+    int rounds = atoi(argv[3]);
+    int server_pid = argc > 4 ? atoi(argv[4]) : 0;
+    if (clients.count < 1 || rounds < 1) {
+        printf("Число соединений и раундов должно быть положительным\n");
+        return 1;
+    }
+
+    // Каждому соединению нужен дескриптор, у ZeroMQ ещё и служебные
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    GatewayFrame frame;
+    init_message(&frame.body);
+    frame.body.type = MSG_GAME_STATE;
+    strcpy(frame.body.game_name, "gateway-bench");
+
+    long rss_before = read_rss(server_pid);
+    int opened = open_clients(&clients);
+    if (opened < clients.count) {
+        close_clients(&clients, opened);
+        return 1;
+    }
+
+    // Первый запрос на каждом соединении: сервер создаёт всё своё состояние
+    for (int i = 0; i < clients.count; i++) {
+        if (round_trip(&clients, i, &frame) != 0) {
+            printf("Ошибка обмена на соединении %d\n", i);
+            close_clients(&clients, opened);
+            return 1;
+        }
+    }
+    long rss_after = read_rss(server_pid);
+
+    long total = (long)clients.count * rounds;
+    long *samples = malloc(total * sizeof(long));
+    if (!samples) {
+        printf("Ошибка выделения памяти\n");
+        close_clients(&clients, opened);
+        return 1;
+    }
+    struct timespec begin, end, start, finish;
+    long n = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < clients.count; i++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (round_trip(&clients, i, &frame) != 0) {
+                // Неполная выборка исказила бы результат
+                printf("Ошибка обмена на соединении %d, раунд %d\n", i, r);
+                free(samples);
+                close_clients(&clients, opened);
+                return 1;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            samples[n++] = elapsed_ns(&start, &finish);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    qsort(samples, n, sizeof(long), compare_long);
+    double sum = 0;
+    for (long i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+
+    printf("Транспорт: %s, соединений: %d, запросов: %ld\n",
+           clients.use_tcp ? "TCP-шлюз" : "ZeroMQ ROUTER", clients.count, n);
+    if (rss_before >= 0 && rss_after >= 0) {
+        printf("Память сервера: %ld КБ -> %ld КБ, %.2f КБ на соединение\n",
+               rss_before, rss_after, (double)(rss_after - rss_before) / clients.count);
+    }
+    if (n > 0) {
+        printf("Задержка, мкс: средняя %.1f, p50 %.1f, p99 %.1f, макс %.1f\n",
+               sum / n / 1000.0, samples[n / 2] / 1000.0,
+               samples[n * 99 / 100] / 1000.0, samples[n - 1] / 1000.0);
+        printf("Пропускная способность: %.0f запросов/с\n", n / (elapsed_ns(&begin, &end) / 1e9));
+    }
+
+    free(samples);
+    close_clients(&clients, opened);
+    return 0;
+}
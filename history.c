@@ -0,0 +1,238 @@
+#include "history.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+const char *history_column_files[HISTORY_COLUMNS] = {
+    "game.u64", "player.u32", "guess.u16", "bulls.u8", "cows.u8", "attempt.u8", "time.u64"
+};
+
+const size_t history_column_widths[HISTORY_COLUMNS] = {
+    sizeof(uint64_t), sizeof(uint32_t), sizeof(uint16_t),
+    sizeof(uint8_t), sizeof(uint8_t), sizeof(uint8_t), sizeof(uint64_t)
+};
+
+// Блок строк, разложенный по колонкам
+typedef struct {
+    int rows;
+    uint64_t game[HISTORY_BLOCK_ROWS];
+    uint32_t player[HISTORY_BLOCK_ROWS];
+    uint16_t guess[HISTORY_BLOCK_ROWS];
+    uint8_t bulls[HISTORY_BLOCK_ROWS];
+    uint8_t cows[HISTORY_BLOCK_ROWS];
+    uint8_t attempt[HISTORY_BLOCK_ROWS];
+    uint64_t time[HISTORY_BLOCK_ROWS];
+} HistoryBlock;
+
+// Двойная буферизация: обработчики дописывают строки в active, поток
+// записи сбрасывает flushing на диск. Под mutex только копирование строки.
+static HistoryBlock *blocks[2];
+static HistoryBlock *active = NULL;
+static HistoryBlock *flushing = NULL;
+static int column_fds[HISTORY_COLUMNS];
+static atomic_int history_enabled = 0;
+static int history_stop = 0;
+
+static pthread_mutex_t history_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t free_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t writer_tid;
+
+// Идентификатор игры: время запуска сервера в старших битах и счётчик,
+// чтобы номера не повторялись после перезапуска
+static uint64_t game_id_base = 0;
+static atomic_uint_fast64_t game_id_counter = 0;
+
+static int write_all(int fd, const void *data, size_t size) {
+    const char *p = (const char*)data;
+
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static void write_block(HistoryBlock *block) {
+    const void *columns[HISTORY_COLUMNS] = {
+        block->game, block->player, block->guess,
+        block->bulls, block->cows, block->attempt, block->time
+    };
+
+    // При передаче управления (server --shm) в те же файлы недолго пишут
+    // два процесса; блок должен лечь во все колонки одним куском
+    flock(column_fds[0], LOCK_EX);
+    for (int c = 0; c < HISTORY_COLUMNS; c++) {
+        if (write_all(column_fds[c], columns[c], block->rows * history_column_widths[c]) != 0) {
+            printf("Ошибка записи истории (%s): %s\n", history_column_files[c], strerror(errno));
+        }
+    }
+    flock(column_fds[0], LOCK_UN);
+}
+
+static void* history_writer(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&history_mutex);
+    for (;;) {
+        if (!flushing && !history_stop) {
+            // Неполный блок сбрасывается раз в секунду
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += 1;
+            pthread_cond_timedwait(&writer_cond, &history_mutex, &deadline);
+        }
+
+        if (!flushing && active->rows > 0) {
+            flushing = active;
+            active = (active == blocks[0]) ? blocks[1] : blocks[0];
+        }
+
+        if (flushing) {
+            HistoryBlock *block = flushing;
+            pthread_mutex_unlock(&history_mutex);
+            write_block(block);
+            pthread_mutex_lock(&history_mutex);
+
+            block->rows = 0;
+            flushing = NULL;
+            pthread_cond_broadcast(&free_cond);
+        } else if (history_stop) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&history_mutex);
+
+    return NULL;
+}
+
+// Открывает (создаёт) каталог истории и запускает поток записи
+int history_open(const char *dir) {
+    char path[512];
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        printf("Ошибка создания каталога истории %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    for (int c = 0; c < HISTORY_COLUMNS; c++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, history_column_files[c]);
+        column_fds[c] = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (column_fds[c] < 0) {
+            printf("Ошибка открытия %s: %s\n", path, strerror(errno));
+            while (--c >= 0) {
+                close(column_fds[c]);
+            }
+            return -1;
+        }
+    }
+
+    blocks[0] = malloc(sizeof(HistoryBlock));
+    blocks[1] = malloc(sizeof(HistoryBlock));
+    if (!blocks[0] || !blocks[1]) {
+        printf("Ошибка выделения памяти для истории\n");
+        free(blocks[0]);
+        free(blocks[1]);
+        for (int c = 0; c < HISTORY_COLUMNS; c++) {
+            close(column_fds[c]);
+        }
+        return -1;
+    }
+    blocks[0]->rows = 0;
+    blocks[1]->rows = 0;
+    active = blocks[0];
+    flushing = NULL;
+    history_stop = 0;
+    game_id_base = (uint64_t)time(NULL) << 24;
+
+    if (pthread_create(&writer_tid, NULL, history_writer, NULL) != 0) {
+        printf("Ошибка создания потока записи истории\n");
+        free(blocks[0]);
+        free(blocks[1]);
+        for (int c = 0; c < HISTORY_COLUMNS; c++) {
+            close(column_fds[c]);
+        }
+        return -1;
+    }
+
+    history_enabled = 1;
+    printf("История попыток пишется в %s/\n", dir);
+    return 0;
+}
+
+// Сбрасывает оставшиеся строки и закрывает файлы
+void history_close(void) {
+    if (!history_enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&history_mutex);
+    history_enabled = 0;
+    history_stop = 1;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&history_mutex);
+    pthread_join(writer_tid, NULL);
+
+    for (int c = 0; c < HISTORY_COLUMNS; c++) {
+        fsync(column_fds[c]);
+        close(column_fds[c]);
+    }
+    free(blocks[0]);
+    free(blocks[1]);
+    active = NULL;
+}
+
+uint64_t history_new_game_id(void) {
+    return game_id_base + atomic_fetch_add_explicit(&game_id_counter, 1, memory_order_relaxed);
+}
+
+void history_record_guess(uint64_t game_id, const char *player, const int *guess,
+                          int bulls, int cows, int attempt) {
+    if (!history_enabled) {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    uint32_t player_id = hash_name(player, MAX_PLAYER_NAME);
+    uint16_t code = 0;
+    for (int i = 0; i < SECRET_LENGTH; i++) {
+        code = code * 10 + guess[i];
+    }
+
+    pthread_mutex_lock(&history_mutex);
+    if (!history_enabled) {
+        pthread_mutex_unlock(&history_mutex);
+        return;
+    }
+
+    // Оба блока заняты - ждём, пока поток записи освободит один
+    while (active->rows == HISTORY_BLOCK_ROWS) {
+        if (!flushing) {
+            flushing = active;
+            active = (active == blocks[0]) ? blocks[1] : blocks[0];
+            pthread_cond_signal(&writer_cond);
+        } else {
+            pthread_cond_wait(&free_cond, &history_mutex);
+        }
+    }
+
+    int row = active->rows++;
+    active->game[row] = game_id;
+    active->player[row] = player_id;
+    active->guess[row] = code;
+    active->bulls[row] = (uint8_t)bulls;
+    active->cows[row] = (uint8_t)cows;
+    active->attempt[row] = (uint8_t)(attempt > 255 ? 255 : attempt);
+    active->time[row] = ms;
+    pthread_mutex_unlock(&history_mutex);
+}
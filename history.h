@@ -0,0 +1,33 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "common.h"
+
+// История попыток в колоночном формате: каталог с файлом на каждую
+// колонку, строки только дописываются. Файлы - плоские массивы
+// фиксированной ширины в порядке байт машины, i-я строка - i-й элемент
+// каждого файла.
+#define HISTORY_DIR "history"
+#define HISTORY_BLOCK_ROWS 65536    // строк в блоке записи
+
+typedef enum {
+    HISTORY_GAME,       // uint64_t: идентификатор игры
+    HISTORY_PLAYER,     // uint32_t: FNV-1a хеш имени игрока
+    HISTORY_GUESS,      // uint16_t: попытка как десятичное число
+    HISTORY_BULLS,      // uint8_t
+    HISTORY_COWS,       // uint8_t
+    HISTORY_ATTEMPT,    // uint8_t: номер попытки игрока в этой игре
+    HISTORY_TIME,       // uint64_t: мс с начала эпохи
+    HISTORY_COLUMNS
+} HistoryColumn;
+
+extern const char *history_column_files[HISTORY_COLUMNS];
+extern const size_t history_column_widths[HISTORY_COLUMNS];
+
+int history_open(const char *dir);
+void history_close(void);
+uint64_t history_new_game_id(void);
+void history_record_guess(uint64_t game_id, const char *player, const int *guess,
+                          int bulls, int cows, int attempt);
+
+#endif // HISTORY_H
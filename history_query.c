@@ -0,0 +1,210 @@
+#include "history.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Агрегаты по истории попыток (server --history):
+//
+//   history_query [каталог] [потоков]
+//
+// Колонки отображаются в память целиком и сканируются параллельно по
+// диапазонам строк. Суммы считаются отдельными проходами по узким
+// колонкам, которые компилятор векторизует.
+
+#define QUERY_MAX_THREADS 256
+#define QUERY_CHUNK 4096    // строк за проход, колонки блока остаются в L1
+
+typedef struct {
+    const void *data[HISTORY_COLUMNS];
+    size_t sizes[HISTORY_COLUMNS];
+    long rows;
+} HistoryFiles;
+
+typedef struct {
+    const HistoryFiles *files;
+    long begin;
+    long end;
+    long wins;
+    long bulls_sum;
+    long cows_sum;
+    long attempts_sum;          // по выигрышным строкам
+    uint64_t time_min;
+    uint64_t time_max;
+    long histogram[256];        // выигрыши по номеру попытки
+} QueryPart;
+
+int map_history(const char *dir, HistoryFiles *files) {
+    char path[512];
+
+    files->rows = -1;
+    for (int c = 0; c < HISTORY_COLUMNS; c++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, history_column_files[c]);
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            printf("Не удалось открыть %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+
+        files->sizes[c] = st.st_size;
+        files->data[c] = NULL;
+        if (st.st_size > 0) {
+            files->data[c] = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (files->data[c] == MAP_FAILED) {
+                printf("Ошибка mmap %s: %s\n", path, strerror(errno));
+                close(fd);
+                return -1;
+            }
+            madvise((void*)files->data[c], st.st_size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+
+        // При аварийной остановке колонки могут отличаться длиной,
+        // берём только полные строки
+        long rows = st.st_size / history_column_widths[c];
+        if (files->rows < 0 || rows < files->rows) {
+            files->rows = rows;
+        }
+    }
+    return 0;
+}
+
+void unmap_history(HistoryFiles *files) {
+    for (int c = 0; c < HISTORY_COLUMNS; c++) {
+        if (files->data[c]) {
+            munmap((void*)files->data[c], files->sizes[c]);
+        }
+    }
+}
+
+static void scan_chunk(QueryPart *part, long begin, int n) {
+    const uint8_t *bulls = (const uint8_t*)part->files->data[HISTORY_BULLS] + begin;
+    const uint8_t *cows = (const uint8_t*)part->files->data[HISTORY_COWS] + begin;
+    const uint8_t *attempt = (const uint8_t*)part->files->data[HISTORY_ATTEMPT] + begin;
+    const uint64_t *times = (const uint64_t*)part->files->data[HISTORY_TIME] + begin;
+    unsigned int bulls_sum = 0, cows_sum = 0, wins = 0, attempts_sum = 0;
+    uint64_t time_min = part->time_min, time_max = part->time_max;
+
+    for (int i = 0; i < n; i++) {
+        bulls_sum += bulls[i];
+    }
+    for (int i = 0; i < n; i++) {
+        cows_sum += cows[i];
+    }
+    for (int i = 0; i < n; i++) {
+        unsigned int win = bulls[i] == SECRET_LENGTH;
+        wins += win;
+        attempts_sum += win * attempt[i];
+    }
+    for (int i = 0; i < n; i++) {
+        time_min = times[i] < time_min ? times[i] : time_min;
+        time_max = times[i] > time_max ? times[i] : time_max;
+    }
+
+    // Гистограмма без ветвлений: проигрышные строки попадают в корзину 0
+    for (int i = 0; i < n; i++) {
+        part->histogram[(bulls[i] == SECRET_LENGTH) * attempt[i]]++;
+    }
+
+    part->bulls_sum += bulls_sum;
+    part->cows_sum += cows_sum;
+    part->wins += wins;
+    part->attempts_sum += attempts_sum;
+    part->time_min = time_min;
+    part->time_max = time_max;
+}
+
+static void* query_worker(void *arg) {
+    QueryPart *part = (QueryPart*)arg;
+
+    for (long row = part->begin; row < part->end; row += QUERY_CHUNK) {
+        long n = part->end - row;
+        scan_chunk(part, row, n > QUERY_CHUNK ? QUERY_CHUNK : (int)n);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *dir = argc > 1 ? argv[1] : HISTORY_DIR;
+    int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > QUERY_MAX_THREADS) threads = QUERY_MAX_THREADS;
+
+    HistoryFiles files;
+    memset(&files, 0, sizeof(files));
+    if (map_history(dir, &files) != 0) {
+        unmap_history(&files);
+        return 1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    QueryPart *parts = calloc(threads, sizeof(QueryPart));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    char *started = calloc(threads, 1);
+    for (int i = 0; i < threads; i++) {
+        parts[i].files = &files;
+        parts[i].begin = files.rows * i / threads;
+        parts[i].end = files.rows * (i + 1) / threads;
+        parts[i].time_min = UINT64_MAX;
+        if (pthread_create(&tids[i], NULL, query_worker, &parts[i]) == 0) {
+            started[i] = 1;
+        } else {
+            query_worker(&parts[i]);
+        }
+    }
+
+    QueryPart total;
+    memset(&total, 0, sizeof(total));
+    total.time_min = UINT64_MAX;
+    for (int i = 0; i < threads; i++) {
+        if (started[i]) {
+            pthread_join(tids[i], NULL);
+        }
+        total.wins += parts[i].wins;
+        total.bulls_sum += parts[i].bulls_sum;
+        total.cows_sum += parts[i].cows_sum;
+        total.attempts_sum += parts[i].attempts_sum;
+        if (parts[i].time_min < total.time_min) total.time_min = parts[i].time_min;
+        if (parts[i].time_max > total.time_max) total.time_max = parts[i].time_max;
+        for (int a = 1; a < 256; a++) {
+            total.histogram[a] += parts[i].histogram[a];
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    printf("Строк (попыток): %ld, просмотрено за %.3f с, потоков: %d\n",
+           files.rows, elapsed, threads);
+    if (files.rows > 0) {
+        time_t first = total.time_min / 1000, last = total.time_max / 1000;
+        char first_text[32], last_text[32];
+        strftime(first_text, sizeof(first_text), "%Y-%m-%d %H:%M:%S", localtime(&first));
+        strftime(last_text, sizeof(last_text), "%Y-%m-%d %H:%M:%S", localtime(&last));
+        printf("Период: %s - %s\n", first_text, last_text);
+        printf("Среднее за попытку: %.3f быков, %.3f коров\n",
+               (double)total.bulls_sum / files.rows, (double)total.cows_sum / files.rows);
+    }
+    printf("Выигранных игр: %ld\n", total.wins);
+
+    if (total.wins > 0) {
+        printf("Среднее число попыток до победы: %.4f\n", (double)total.attempts_sum / total.wins);
+        printf("\nРаспределение попыток:\n");
+        for (int a = 1; a < 256; a++) {
+            if (total.histogram[a] > 0) {
+                printf("  %3d: %10ld (%6.2f%%)\n", a, total.histogram[a],
+                       total.histogram[a] * 100.0 / total.wins);
+            }
+        }
+    }
+
+    free(parts);
+    free(tids);
+    free(started);
+    unmap_history(&files);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "leaderboard.h"
+#include <pthread.h>
+
+// Таблица статистики с открытой адресацией и линейным пробированием
+static PlayerStats stats_table[MAX_STATS_PLAYERS];
+static int stats_count = 0;
+
+// Индексы лучших игроков в stats_table, по убыванию рейтинга
+static int top[LEADERBOARD_SIZE];
+static int top_count = 0;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Возвращает индекс записи игрока, при create создаёт её; -1 если нет места.
+// Пустое имя означает свободную ячейку, такому игроку запись не заводится.
+static int find_entry(const char *name, int create) {
+    if (name[0] == '\0') {
+        return -1;
+    }
+
+    unsigned int i = hash_name(name, MAX_PLAYER_NAME) & (MAX_STATS_PLAYERS - 1);
+
+    for (int probe = 0; probe < MAX_STATS_PLAYERS; probe++) {
+        PlayerStats *entry = &stats_table[i];
+
+        if (entry->name[0] == '\0') {
+            if (!create || stats_count >= MAX_STATS_PLAYERS - 1) {
+                return -1;
+            }
+            strncpy(entry->name, name, MAX_PLAYER_NAME - 1);
+            stats_count++;
+            return (int)i;
+        }
+        if (strcmp(entry->name, name) == 0) {
+            return (int)i;
+        }
+        i = (i + 1) & (MAX_STATS_PLAYERS - 1);
+    }
+
+    return -1;
+}
+
+// Больше побед - выше; при равенстве меньше средних попыток. Число игр
+// в сравнение не входит: оно растёт без побед и сдвигало бы игрока вниз,
+// а update_top двигает записи только вверх.
+static int ranks_higher(PlayerStats *a, PlayerStats *b) {
+    if (a->wins != b->wins) {
+        return a->wins > b->wins;
+    }
+    long lhs = (long)a->win_attempts * b->wins;
+    long rhs = (long)b->win_attempts * a->wins;
+    return lhs < rhs;
+}
+
+// Рейтинг игрока после победы только растёт, поэтому достаточно
+// поставить его в таблицу и поднять на нужную позицию
+static void update_top(int idx) {
+    int pos = -1;
+
+    for (int i = 0; i < top_count; i++) {
+        if (top[i] == idx) {
+            pos = i;
+            break;
+        }
+    }
+
+    if (pos < 0) {
+        if (top_count < LEADERBOARD_SIZE) {
+            pos = top_count++;
+        } else if (ranks_higher(&stats_table[idx], &stats_table[top[top_count - 1]])) {
+            pos = top_count - 1;
+        } else {
+            return;
+        }
+        top[pos] = idx;
+    }
+
+    while (pos > 0 && ranks_higher(&stats_table[idx], &stats_table[top[pos - 1]])) {
+        top[pos] = top[pos - 1];
+        top[--pos] = idx;
+    }
+}
+
+void stats_record_game(const char *name) {
+    pthread_mutex_lock(&stats_mutex);
+
+    int idx = find_entry(name, 1);
+    if (idx >= 0) {
+        stats_table[idx].games++;
+    }
+
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+void stats_record_win(const char *name, int attempts) {
+    pthread_mutex_lock(&stats_mutex);
+
+    int idx = find_entry(name, 1);
+    if (idx >= 0) {
+        stats_table[idx].wins++;
+        stats_table[idx].win_attempts += attempts;
+        update_top(idx);
+    }
+
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+int stats_lookup(const char *name, PlayerStats *out) {
+    pthread_mutex_lock(&stats_mutex);
+
+    int idx = find_entry(name, 0);
+    if (idx >= 0) {
+        *out = stats_table[idx];
+    }
+
+    pthread_mutex_unlock(&stats_mutex);
+    return idx >= 0;
+}
+
+int leaderboard_top(PlayerStats *out, int max_count) {
+    pthread_mutex_lock(&stats_mutex);
+
+    int count = top_count < max_count ? top_count : max_count;
+    for (int i = 0; i < count; i++) {
+        out[i] = stats_table[top[i]];
+    }
+
+    pthread_mutex_unlock(&stats_mutex);
+    return count;
+}
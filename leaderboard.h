@@ -0,0 +1,16 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include "common.h"
+
+#define MAX_STATS_PLAYERS 4096  // ёмкость таблицы статистики (степень двойки)
+
+// Статистика игроков и таблица лидеров. Таблица лидеров обновляется
+// при каждой победе за O(LEADERBOARD_SIZE), поэтому запросы не обходят
+// всех игроков и не берут games_mutex.
+void stats_record_game(const char *name);
+void stats_record_win(const char *name, int attempts);
+int stats_lookup(const char *name, PlayerStats *out);
+int leaderboard_top(PlayerStats *out, int max_count);
+
+#endif // LEADERBOARD_H
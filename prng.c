@@ -0,0 +1,95 @@
+#include "prng.h"
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/random.h>
+
+static _Thread_local Prng local_rng;
+static _Thread_local int local_seeded = 0;
+
+static int deterministic = 0;
+static uint64_t base_seed = 0;
+static atomic_uint_fast64_t next_stream = 0;
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64 разворачивает 64-битное зерно в состояние без нулевых слов
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void prng_seed(Prng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+uint64_t prng_next(Prng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+// Равномерное число в [0, bound) без смещения остатка (метод Лемира)
+uint32_t prng_below(Prng *rng, uint32_t bound) {
+    uint64_t m = (uint64_t)(uint32_t)(prng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (uint64_t)(uint32_t)(prng_next(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+void prng_set_seed(uint64_t seed) {
+    base_seed = seed;
+    deterministic = 1;
+}
+
+// Переводит генератор потока на поток чисел stream общего зерна;
+// без --seed генератор потока остаётся прежним
+void prng_seed_local(uint64_t stream) {
+    if (!deterministic) {
+        prng_local();
+        return;
+    }
+    prng_seed(&local_rng, base_seed + stream * 0x9e3779b97f4a7c15ull);
+    local_seeded = 1;
+}
+
+Prng *prng_local(void) {
+    if (local_seeded) {
+        return &local_rng;
+    }
+    if (deterministic) {
+        prng_seed_local(atomic_fetch_add(&next_stream, 1));
+        return &local_rng;
+    }
+
+    uint64_t seed;
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        seed = (uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)(uintptr_t)&local_rng;
+    }
+    prng_seed(&local_rng, seed);
+    local_seeded = 1;
+    return &local_rng;
+}
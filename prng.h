@@ -0,0 +1,25 @@
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdint.h>
+
+// xoshiro256** - быстрый генератор с состоянием в 256 бит. У каждого
+// потока своё состояние, поэтому нет общих блокировок и гонок.
+typedef struct {
+    uint64_t s[4];
+} Prng;
+
+void prng_seed(Prng *rng, uint64_t seed);
+uint64_t prng_next(Prng *rng);
+uint32_t prng_below(Prng *rng, uint32_t bound);
+
+// Генератор текущего потока; при первом обращении засевается из
+// getrandom или, в детерминированном режиме, из общего зерна
+Prng *prng_local(void);
+
+// Детерминированный режим (--seed): потоки получают потоки чисел
+// seed, seed+1, ... в порядке первого обращения к генератору
+void prng_set_seed(uint64_t seed);
+void prng_seed_local(uint64_t stream);
+
+#endif // PRNG_H
@@ -0,0 +1,188 @@
+#include "profile.h"
+
+#ifdef SERVER_PROFILE
+
+#include "common.h"
+#include <signal.h>
+#include <stdatomic.h>
+
+#define PROF_MAX_SLOTS 128   // одновременно работающих потоков
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[PROF_BUCKETS];
+} ProfHistogram;
+
+// Гистограммы одного потока. Слот занимается потоком на время жизни и
+// не очищается при освобождении: следующий поток продолжает накопление,
+// поэтому слияние и общие счётчики не нужны.
+typedef struct {
+    atomic_int in_use;
+    ProfHistogram hist[PROF_MAX_TYPES][PROF_METRICS];
+} ProfSlot;
+
+static ProfSlot prof_slots[PROF_MAX_SLOTS];
+static volatile sig_atomic_t prof_dump_requested = 0;
+
+static _Thread_local ProfSlot *tl_slot = NULL;
+static _Thread_local int tl_type = PROF_MAX_TYPES - 1;
+static _Thread_local uint64_t tl_hold_start = 0;
+
+static const char *metric_names[PROF_METRICS] = {
+    "recv", "dispatch", "handler", "lock_wait", "lock_hold", "send", "service"
+};
+
+static const char *type_name(int type) {
+    switch (type) {
+        case MSG_CREATE_GAME:     return "CREATE_GAME";
+        case MSG_JOIN_GAME:       return "JOIN_GAME";
+        case MSG_FIND_GAME:       return "FIND_GAME";
+        case MSG_MAKE_GUESS:      return "MAKE_GUESS";
+        case MSG_LEAVE_GAME:      return "LEAVE_GAME";
+        case MSG_LIST_GAMES:      return "LIST_GAMES";
+        case MSG_GET_LEADERBOARD: return "GET_LEADERBOARD";
+        case MSG_GET_HINT:        return "GET_HINT";
+        case MSG_GAME_STATE:      return "GAME_STATE";
+        case PROF_MAX_TYPES - 1:  return "OTHER";
+        default:                  return "UNKNOWN";
+    }
+}
+
+static ProfSlot* current_slot(void) {
+    if (tl_slot == NULL) {
+        for (int i = 0; i < PROF_MAX_SLOTS; i++) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong(&prof_slots[i].in_use, &expected, 1)) {
+                tl_slot = &prof_slots[i];
+                break;
+            }
+        }
+    }
+    return tl_slot;
+}
+
+static void hist_add(ProfHistogram *h, uint64_t value) {
+    int bucket = value ? 64 - __builtin_clzll(value) : 0;
+    if (bucket >= PROF_BUCKETS) {
+        bucket = PROF_BUCKETS - 1;
+    }
+    h->count++;
+    h->sum += value;
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->buckets[bucket]++;
+}
+
+// Верхняя граница корзины, в которую попадает заданный перцентиль
+static uint64_t hist_percentile(ProfHistogram *h, double p) {
+    uint64_t target = (uint64_t)(h->count * p);
+    uint64_t seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > target) {
+            uint64_t bound = b ? (1ull << b) - 1 : 0;
+            return bound < h->max ? bound : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void prof_dump(void) {
+    static ProfHistogram total[PROF_MAX_TYPES][PROF_METRICS];
+    memset(total, 0, sizeof(total));
+
+    // Чтение без синхронизации: для диагностики допустимы неточности
+    for (int s = 0; s < PROF_MAX_SLOTS; s++) {
+        for (int t = 0; t < PROF_MAX_TYPES; t++) {
+            for (int m = 0; m < PROF_METRICS; m++) {
+                ProfHistogram *src = &prof_slots[s].hist[t][m];
+                ProfHistogram *dst = &total[t][m];
+                dst->count += src->count;
+                dst->sum += src->sum;
+                if (src->max > dst->max) {
+                    dst->max = src->max;
+                }
+                for (int b = 0; b < PROF_BUCKETS; b++) {
+                    dst->buckets[b] += src->buckets[b];
+                }
+            }
+        }
+    }
+
+    fprintf(stderr, "\n=== Профиль сервера (такты) ===\n");
+    fprintf(stderr, "%-16s %-10s %10s %12s %12s %12s %12s\n",
+            "тип", "интервал", "count", "mean", "p50", "p99", "max");
+    for (int t = 0; t < PROF_MAX_TYPES; t++) {
+        for (int m = 0; m < PROF_METRICS; m++) {
+            ProfHistogram *h = &total[t][m];
+            if (h->count == 0) {
+                continue;
+            }
+            fprintf(stderr, "%-16s %-10s %10llu %12llu %12llu %12llu %12llu\n",
+                    type_name(t), metric_names[m],
+                    (unsigned long long)h->count,
+                    (unsigned long long)(h->sum / h->count),
+                    (unsigned long long)hist_percentile(h, 0.50),
+                    (unsigned long long)hist_percentile(h, 0.99),
+                    (unsigned long long)h->max);
+        }
+    }
+}
+
+static void prof_signal_handler(int signum) {
+    (void)signum;
+    prof_dump_requested = 1;
+}
+
+void prof_install(void) {
+    signal(SIGUSR1, prof_signal_handler);
+}
+
+// Вызывается из основного цикла: вывод из обработчика сигнала небезопасен
+void prof_poll(void) {
+    if (prof_dump_requested) {
+        prof_dump_requested = 0;
+        prof_dump();
+    }
+}
+
+void prof_begin(int type) {
+    tl_type = (type >= 0 && type < PROF_MAX_TYPES - 1) ? type : PROF_MAX_TYPES - 1;
+}
+
+void prof_record(int metric, uint64_t start) {
+    ProfSlot *slot = current_slot();
+    if (slot) {
+        hist_add(&slot->hist[tl_type][metric], prof_now() - start);
+    }
+}
+
+int prof_mutex_lock(pthread_mutex_t *mutex) {
+    uint64_t start = prof_now();
+    int rc = pthread_mutex_lock(mutex);
+    tl_hold_start = prof_now();
+
+    ProfSlot *slot = current_slot();
+    if (slot) {
+        hist_add(&slot->hist[tl_type][PROF_LOCK_WAIT], tl_hold_start - start);
+    }
+    return rc;
+}
+
+void prof_mutex_unlock(pthread_mutex_t *mutex) {
+    prof_record(PROF_LOCK_HOLD, tl_hold_start);
+    pthread_mutex_unlock(mutex);
+}
+
+void prof_thread_exit(void) {
+    if (tl_slot) {
+        atomic_store(&tl_slot->in_use, 0);
+        tl_slot = NULL;
+    }
+    tl_type = PROF_MAX_TYPES - 1;
+}
+
+#endif // SERVER_PROFILE
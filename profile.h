@@ -0,0 +1,75 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Инструментирование горячего пути сервера. Включается при сборке с
+// -DSERVER_PROFILE (cmake -DENABLE_PROFILING=ON); без него все макросы
+// раскрываются в пустые выражения или в обычные вызовы pthread.
+
+#include <pthread.h>
+#include <stdint.h>
+
+#ifdef SERVER_PROFILE
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define PROF_MAX_TYPES 32    // типов сообщений в гистограммах
+#define PROF_BUCKETS 48      // корзины по степеням двойки тактов
+
+// Измеряемые интервалы
+typedef enum {
+    PROF_RECV,          // приём разделителя и тела после identity
+    PROF_DISPATCH,      // от приёма до начала обработки в потоке
+    PROF_HANDLER,       // process_message
+    PROF_LOCK_WAIT,     // ожидание games_mutex
+    PROF_LOCK_HOLD,     // удержание games_mutex
+    PROF_SEND,          // zmq_send ответа
+    PROF_SERVICE,       // от приёма до отправки ответа
+    PROF_METRICS
+} ProfMetric;
+
+static inline uint64_t prof_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void prof_install(void);
+void prof_poll(void);
+void prof_begin(int type);
+void prof_record(int metric, uint64_t start);
+int prof_mutex_lock(pthread_mutex_t *mutex);
+void prof_mutex_unlock(pthread_mutex_t *mutex);
+void prof_thread_exit(void);
+
+#define PROF_TIMESTAMP(var)         uint64_t var = prof_now()
+#define PROF_SET_TIMESTAMP(lvalue)  ((lvalue) = prof_now())
+#define PROF_BEGIN(type)            prof_begin(type)
+#define PROF_RECORD(metric, start)  prof_record((metric), (start))
+#define PROF_MUTEX_LOCK(mutex)      prof_mutex_lock(mutex)
+#define PROF_MUTEX_UNLOCK(mutex)    prof_mutex_unlock(mutex)
+#define PROF_THREAD_EXIT()          prof_thread_exit()
+#define PROF_INSTALL()              prof_install()
+#define PROF_POLL()                 prof_poll()
+
+#else
+
+#define PROF_TIMESTAMP(var)         ((void)0)
+#define PROF_SET_TIMESTAMP(lvalue)  ((void)0)
+#define PROF_BEGIN(type)            ((void)0)
+#define PROF_RECORD(metric, start)  ((void)0)
+#define PROF_MUTEX_LOCK(mutex)      pthread_mutex_lock(mutex)
+#define PROF_MUTEX_UNLOCK(mutex)    pthread_mutex_unlock(mutex)
+#define PROF_THREAD_EXIT()          ((void)0)
+#define PROF_INSTALL()              ((void)0)
+#define PROF_POLL()                 ((void)0)
+
+#endif // SERVER_PROFILE
+
+#endif // PROFILE_H
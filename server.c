@@ -1,113 +1,450 @@
-#include "common.h"
+#include "server.h"
+#include "game_store.h"
+#include "gateway.h"
+#include "history.h"
+#include "prng.h"
+#include "simulation.h"
+#include "leaderboard.h"
+#include "profile.h"
 #include <signal.h>
 #include <unistd.h>
-#include <pthread.h>
+#include <sys/eventfd.h>
 
 #define SERVER_ENDPOINT "tcp://*:5555"
 #define MAX_THREADS 100
-
-// Структура игрока
-typedef struct {
-    char name[MAX_PLAYER_NAME];
-    int is_active;
-    int attempts;
-} Player;
-
-// Структура игры
-typedef struct {
-    char name[MAX_GAME_NAME];
-    int secret[SECRET_LENGTH];
-    int max_players;
-    int current_players;
-    Player players[MAX_PLAYERS];
-    int is_active;
-    int is_finished;
-    char winner[MAX_PLAYER_NAME];
-} Game;
+#define PLAYER_IDLE_TIMEOUT 600   // секунд без запросов до удаления игрока
+#define GAME_IDLE_TIMEOUT 1800    // секунд без активности до закрытия игры
+#define HEARTBEAT_IVL 5000        // мс между пингами ZeroMQ
+#define HEARTBEAT_TIMEOUT 15000   // мс без ответа на пинг до разрыва
+#define HANDOVER_QUIET_MS 10      // тишина перед освобождением endpoint
+#define HANDOVER_MAX_MS 500       // дольше запросы не дообрабатываем
+#define BIND_RETRY_MS 5000        // сколько новый процесс ждёт endpoint
+#define SHUTDOWN_WAIT_MS 2000     // сколько ждём обработчики при остановке
 
 // Глобальные переменные
-Game games[100];
-int game_count = 0;
+GameTable game_table;        // таблица игр многопоточного режима
+GameTable *served_table = &game_table;   // или таблица в разделяемой памяти
 int running = 1;
-pthread_mutex_t games_mutex = PTHREAD_MUTEX_INITIALIZER;
+volatile sig_atomic_t handover_requested = 0;   // SIGUSR2 от нового процесса
+int handed_over = 0;
+atomic_int in_flight = 0;    // запросы, ответ на которые ещё не отправлен
+atomic_int live_handlers = 0;   // потоки обработки, ещё не вышедшие из handle_client
 void *global_context = NULL;
 
-// Структура для передачи данных в поток
-typedef struct {
-    void *socket;
-    Message request;
-    char identity[256];
-    int identity_size;
+#define REQUEST_POOL_BLOCK 64
+#define RECV_BATCH 64
+
+// Контекст запроса, передаётся в поток обработки. Кадры identity и тела
+// остаются в zmq_msg_t без копирования, ответ отправляется прямо из
+// контекста через zmq_msg_init_data. Тело копируется только если ZeroMQ
+// отдал его по невыровненному адресу внутри буфера приёма.
+typedef struct ClientRequest {
+    zmq_msg_t identity;
+    zmq_msg_t body;
+    Message *request;       // тело в буфере ZeroMQ или в aligned_request
+    Message aligned_request;
+    Message response;
+    struct RequestPool *pool;
+    struct ClientRequest *next;
+#ifdef SERVER_PROFILE
+    uint64_t t_recv;
+    int request_type;
+#endif
 } ClientRequest;
 
+// Пул контекстов потока-приёмника. Брать может только владелец, а
+// возвращает их поток ввода-вывода ZeroMQ после отправки ответа, поэтому
+// возвраты идут в отдельный lock-free стек, который владелец забирает
+// целиком.
+typedef struct RequestPool {
+    ClientRequest *free_list;
+    _Atomic(ClientRequest*) returned;
+    void **blocks;
+    int block_count;
+} RequestPool;
+
+static _Thread_local RequestPool request_pool;
+
+ClientRequest* pool_get(void) {
+    RequestPool *pool = &request_pool;
+    
+    if (pool->free_list == NULL) {
+        pool->free_list = atomic_exchange(&pool->returned, NULL);
+    }
+    
+    if (pool->free_list == NULL) {
+        ClientRequest *block = malloc(sizeof(ClientRequest) * REQUEST_POOL_BLOCK);
+        void **blocks = realloc(pool->blocks, sizeof(void*) * (pool->block_count + 1));
+        if (!block || !blocks) {
+            free(block);
+            if (blocks) pool->blocks = blocks;
+            return NULL;
+        }
+        pool->blocks = blocks;
+        pool->blocks[pool->block_count++] = block;
+        
+        for (int i = 0; i < REQUEST_POOL_BLOCK; i++) {
+            block[i].pool = pool;
+            block[i].next = pool->free_list;
+            pool->free_list = &block[i];
+        }
+    }
+    
+    ClientRequest *req = pool->free_list;
+    pool->free_list = req->next;
+    return req;
+}
+
+void pool_put(ClientRequest *req) {
+    RequestPool *pool = req->pool;
+    ClientRequest *head = atomic_load(&pool->returned);
+    do {
+        req->next = head;
+    } while (!atomic_compare_exchange_weak(&pool->returned, &head, req));
+}
+
+// Освобождает блоки пула; вызывать после zmq_ctx_destroy
+void pool_destroy(void) {
+    for (int i = 0; i < request_pool.block_count; i++) {
+        free(request_pool.blocks[i]);
+    }
+    free(request_pool.blocks);
+    memset(&request_pool, 0, sizeof(request_pool));
+}
+
+// ZeroMQ освобождает ответ после отправки - возвращаем контекст в пул
+void release_request(void *data, void *hint) {
+    (void)data;
+    pool_put((ClientRequest*)hint);
+}
+
+// Обработанные запросы. Сокет ZeroMQ нельзя использовать из нескольких
+// потоков, поэтому ответы отправляет поток-приёмник: обработчики кладут
+// контекст в стек и будят его через eventfd.
+_Atomic(ClientRequest*) completed_requests = NULL;
+int completion_fd = -1;
+
+void complete_request(ClientRequest *req) {
+    ClientRequest *head = atomic_load(&completed_requests);
+    do {
+        req->next = head;
+    } while (!atomic_compare_exchange_weak(&completed_requests, &head, req));
+    
+    uint64_t one = 1;
+    if (write(completion_fd, &one, sizeof(one)) < 0) {
+        printf("Ошибка сигнала о готовом ответе: %s\n", strerror(errno));
+    }
+}
+
+// Отправляет все готовые ответы в порядке завершения обработки
+void send_completed(void *socket) {
+    uint64_t pending;
+    if (read(completion_fd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) {
+        printf("Ошибка чтения eventfd: %s\n", strerror(errno));
+    }
+    
+    ClientRequest *list = atomic_exchange(&completed_requests, NULL);
+    ClientRequest *ordered = NULL;
+    while (list) {
+        ClientRequest *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    
+    while (ordered) {
+        ClientRequest *req = ordered;
+        ordered = req->next;
+        
+        PROF_BEGIN(req->request_type);
+        PROF_TIMESTAMP(t_send);
+        
+        // identity уходит тем же кадром, что пришёл, ответ - без копирования
+        if (zmq_msg_send(&req->identity, socket, ZMQ_SNDMORE) == -1) {
+            zmq_msg_close(&req->identity);
+        }
+        zmq_send(socket, "", 0, ZMQ_SNDMORE);
+        
+        zmq_msg_t reply;
+        zmq_msg_init_data(&reply, &req->response, sizeof(Message), release_request, req);
+        if (zmq_msg_send(&reply, socket, 0) == -1) {
+            zmq_msg_close(&reply);
+        }
+        
+        PROF_RECORD(PROF_SEND, t_send);
+        PROF_RECORD(PROF_SERVICE, req->t_recv);
+        atomic_fetch_sub(&in_flight, 1);
+    }
+}
+
+// Запись в игру под блокировкой таблицы. Читатели MSG_GAME_STATE не берут
+// блокировку, а повторяют чтение, если seq изменился или был нечётным.
+static inline void game_write_begin(Game *game) {
+    unsigned seq = atomic_load_explicit(&game->seq, memory_order_relaxed);
+    atomic_store_explicit(&game->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void game_write_end(Game *game) {
+    unsigned seq = atomic_load_explicit(&game->seq, memory_order_relaxed);
+    atomic_store_explicit(&game->seq, seq + 1, memory_order_release);
+}
+
+// Блокировка таблицы игр; при SERVER_PROFILE замеряет ожидание и удержание.
+// Таблица шарда принадлежит одному потоку и не блокируется.
+static inline void lock_games(GameTable *table) {
+    if (table->shared && PROF_MUTEX_LOCK(&table->mutex) == EOWNERDEAD) {
+        // Процесс-владелец умер под блокировкой: закрываем его незавершённые
+        // записи seqlock, иначе читатели будут ждать их вечно
+        for (int i = 0; i < table->game_count; i++) {
+            Game *game = &table->games[i];
+            if (atomic_load_explicit(&game->seq, memory_order_relaxed) & 1) {
+                game_write_end(game);
+            }
+        }
+        pthread_mutex_consistent(&table->mutex);
+    }
+}
+
+static inline void unlock_games(GameTable *table) {
+    if (table->shared) {
+        PROF_MUTEX_UNLOCK(&table->mutex);
+    }
+}
+
+// Секунды по CLOCK_MONOTONIC - тики колеса таймеров
+uint32_t server_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec;
+}
+
+// Таймер игры и таймеры слотов её игроков
+static inline int game_timer_id(GameTable *table, Game *game) {
+    return (int)(game - table->games) * (MAX_PLAYERS + 1);
+}
+
+static inline int player_timer_id(GameTable *table, Game *game, int slot) {
+    return game_timer_id(table, game) + 1 + slot;
+}
+
+// Отмечает активность игрока; колесо не трогаем - при срабатывании
+// таймер сам переставится на last_active + таймаут
+void touch_player(Game *game, Player *player) {
+    player->last_active = game->last_active = server_now();
+}
+
 void signal_handler(int signum) {
     printf("\nПолучен сигнал %d. Завершение работы сервера...\n", signum);
     running = 0;
 }
 
-Game* find_game_by_name(const char *name) {
-    pthread_mutex_lock(&games_mutex);
+// Новый процесс просит освободить endpoint
+void handover_handler(int signum) {
+    (void)signum;
+    handover_requested = 1;
+}
+
+// Миллисекунды по CLOCK_MONOTONIC
+long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+Game* find_game_by_name(GameTable *table, const char *name) {
+    lock_games(table);
     Game *result = NULL;
-    for (int i = 0; i < game_count; i++) {
-        if (strcmp(games[i].name, name) == 0 && games[i].is_active) {
-            result = &games[i];
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, name) == 0 && table->games[i].is_active) {
+            result = &table->games[i];
             break;
         }
     }
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
     return result;
 }
 
-Game* find_available_game() {
-    pthread_mutex_lock(&games_mutex);
+Game* find_available_game(GameTable *table) {
+    lock_games(table);
     Game *result = NULL;
-    for (int i = 0; i < game_count; i++) {
-        if (games[i].is_active && 
-            games[i].current_players < games[i].max_players &&
-            !games[i].is_finished) {
-            result = &games[i];
+    for (int i = 0; i < table->game_count; i++) {
+        if (table->games[i].is_active && 
+            table->games[i].current_players < table->games[i].max_players &&
+            !table->games[i].is_finished) {
+            result = &table->games[i];
             break;
         }
     }
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
     return result;
 }
 
-void handle_create_game(Message *request, Message *response) {
-    pthread_mutex_lock(&games_mutex);
+// Закрывает игру и освобождает её слот. Вызывать под блокировкой таблицы.
+void close_game(GameTable *table, Game *game) {
+    game_write_begin(game);
+    game->is_active = 0;
+    game->current_players = 0;
+    game_write_end(game);
     
-    if (game_count >= 100) {
-        pthread_mutex_unlock(&games_mutex);
-        response->type = MSG_ERROR;
-        strcpy(response->error_msg, "Достигнут лимит игр на сервере");
+    timer_cancel(&table->wheel, game_timer_id(table, game));
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        timer_cancel(&table->wheel, player_timer_id(table, game, i));
+    }
+}
+
+// Удаляет игрока из игры: на его место переносится последний игрок
+// вместе с таймером, освободившееся место сразу доступно для поиска игры.
+// Пустая игра закрывается. Вызывать под блокировкой таблицы.
+void remove_player(GameTable *table, Game *game, int idx) {
+    game_write_begin(game);
+    int last = --game->current_players;
+    if (idx != last) {
+        game->players[idx] = game->players[last];
+    }
+    game->players[last].is_active = 0;
+    game_write_end(game);
+    
+    TimerNode *moved = &table->wheel.nodes[player_timer_id(table, game, last)];
+    if (idx != last && moved->level != TIMER_NONE) {
+        timer_schedule(&table->wheel, player_timer_id(table, game, idx), moved->expires);
+    } else {
+        timer_cancel(&table->wheel, player_timer_id(table, game, idx));
+    }
+    timer_cancel(&table->wheel, player_timer_id(table, game, last));
+    
+    if (game->current_players == 0) {
+        printf("Игра '%s' закрыта: не осталось игроков\n", game->name);
+        close_game(table, game);
+    }
+}
+
+// Срабатывание таймера простоя. Активность не переставляет таймеры,
+// поэтому здесь проверяем last_active и при необходимости ставим заново.
+void expire_timer(int id, void *arg) {
+    GameTable *table = (GameTable*)arg;
+    Game *game = &table->games[id / (MAX_PLAYERS + 1)];
+    int slot = id % (MAX_PLAYERS + 1) - 1;
+    uint32_t now = table->wheel.now;
+    
+    if (!game->is_active) {
+        return;
+    }
+    
+    // Колесо догоняет пропущенные секунды по одной, и last_active может
+    // оказаться позже обрабатываемой секунды - разность берём со знаком
+    if (slot < 0) {
+        if ((int32_t)(now - game->last_active) < GAME_IDLE_TIMEOUT) {
+            timer_schedule(&table->wheel, id, game->last_active + GAME_IDLE_TIMEOUT);
+            return;
+        }
+        printf("Игра '%s' закрыта по неактивности\n", game->name);
+        close_game(table, game);
+        return;
+    }
+    
+    if (slot >= game->current_players) {
+        return;
+    }
+    
+    Player *player = &game->players[slot];
+    if ((int32_t)(now - player->last_active) < PLAYER_IDLE_TIMEOUT) {
+        timer_schedule(&table->wheel, id, player->last_active + PLAYER_IDLE_TIMEOUT);
         return;
     }
     
+    printf("Игрок '%s' удалён из игры '%s' по неактивности\n", player->name, game->name);
+    remove_player(table, game, slot);
+}
+
+// Продвигает колесо таймеров таблицы до текущего момента
+void game_table_tick(GameTable *table) {
+    lock_games(table);
+    timer_advance(&table->wheel, server_now(), expire_timer, table);
+    unlock_games(table);
+}
+
+// Раз в секунду продвигает колесо таймеров общей таблицы
+void* timer_thread(void *arg) {
+    GameTable *table = (GameTable*)arg;
+    
+    while (running) {
+        sleep(1);
+        game_table_tick(table);
+    }
+    
+    return NULL;
+}
+
+void game_table_init(GameTable *table, int shared) {
+    memset(table, 0, sizeof(GameTable));
+    table->shared = shared;
+    if (shared == TABLE_THREADS) {
+        pthread_mutex_init(&table->mutex, NULL);
+    } else if (shared == TABLE_PROCESSES) {
+        // Блокировку делят процессы; robust - чтобы падение одного из них
+        // не оставило таблицу заблокированной навсегда
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&table->mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    timer_wheel_init(&table->wheel, server_now());
+}
+
+void handle_create_game(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
+    
     // Проверка существования игры
     int game_exists = 0;
-    for (int i = 0; i < game_count; i++) {
-        if (strcmp(games[i].name, request->game_name) == 0 && games[i].is_active) {
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, request->game_name) == 0 && table->games[i].is_active) {
             game_exists = 1;
             break;
         }
     }
     
     if (game_exists) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Игра с таким именем уже существует");
         return;
     }
     
     if (request->max_players < 1 || request->max_players > MAX_PLAYERS) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         sprintf(response->error_msg, "Количество игроков должно быть от 1 до %d", MAX_PLAYERS);
         return;
     }
     
-    Game *game = &games[game_count++];
+    // Занимаем слот закрытой игры, иначе новый в конце таблицы
+    int slot = -1;
+    for (int i = 0; i < table->game_count; i++) {
+        if (!table->games[i].is_active) {
+            slot = i;
+            break;
+        }
+    }
+    
+    if (slot < 0) {
+        if (table->game_count >= MAX_GAMES) {
+            unlock_games(table);
+            response->type = MSG_ERROR;
+            strcpy(response->error_msg, "Достигнут лимит игр на сервере");
+            return;
+        }
+        slot = table->game_count;
+    }
+    
+    // Слот заполняется до увеличения table->game_count, чтобы читатели без
+    // блокировки не увидели недописанную игру
+    Game *game = &table->games[slot];
+    game_write_begin(game);
     strcpy(game->name, request->game_name);
+    game->id = history_new_game_id();
     game->max_players = request->max_players;
     game->current_players = 1;
     game->is_active = 1;
@@ -118,9 +455,19 @@ void handle_create_game(Message *request, Message *response) {
     strcpy(game->players[0].name, request->player_name);
     game->players[0].is_active = 1;
     game->players[0].attempts = 0;
+    candidate_set_reset(&game->players[0].candidates);
     
     // Генерируем секретное число
     generate_secret(game->secret);
+    game_write_end(game);
+    if (slot == table->game_count) {
+        table->game_count++;
+    }
+    
+    touch_player(game, &game->players[0]);
+    timer_schedule(&table->wheel, game_timer_id(table, game), game->last_active + GAME_IDLE_TIMEOUT);
+    timer_schedule(&table->wheel, player_timer_id(table, game, 0), game->last_active + PLAYER_IDLE_TIMEOUT);
+    stats_record_game(request->player_name);
     
     printf("Создана игра '%s' с секретным числом: %d%d%d%d\n", 
            game->name, game->secret[0], game->secret[1], 
@@ -131,36 +478,36 @@ void handle_create_game(Message *request, Message *response) {
     response->max_players = game->max_players;
     response->player_count = game->current_players;
     
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
 }
 
-void handle_join_game(Message *request, Message *response) {
-    pthread_mutex_lock(&games_mutex);
+void handle_join_game(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
     
     Game *game = NULL;
-    for (int i = 0; i < game_count; i++) {
-        if (strcmp(games[i].name, request->game_name) == 0 && games[i].is_active) {
-            game = &games[i];
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, request->game_name) == 0 && table->games[i].is_active) {
+            game = &table->games[i];
             break;
         }
     }
     
     if (game == NULL) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Игра не найдена");
         return;
     }
     
     if (game->is_finished) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Игра уже завершена");
         return;
     }
     
     if (game->current_players >= game->max_players) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Игра заполнена");
         return;
@@ -169,7 +516,7 @@ void handle_join_game(Message *request, Message *response) {
     // Проверяем, не присоединился ли игрок уже
     for (int i = 0; i < game->current_players; i++) {
         if (strcmp(game->players[i].name, request->player_name) == 0) {
-            pthread_mutex_unlock(&games_mutex);
+            unlock_games(table);
             response->type = MSG_ERROR;
             strcpy(response->error_msg, "Вы уже в этой игре");
             return;
@@ -177,10 +524,16 @@ void handle_join_game(Message *request, Message *response) {
     }
     
     // Добавляем игрока
+    game_write_begin(game);
     int idx = game->current_players++;
     strcpy(game->players[idx].name, request->player_name);
     game->players[idx].is_active = 1;
     game->players[idx].attempts = 0;
+    game_write_end(game);
+    candidate_set_reset(&game->players[idx].candidates);
+    touch_player(game, &game->players[idx]);
+    timer_schedule(&table->wheel, player_timer_id(table, game, idx), game->last_active + PLAYER_IDLE_TIMEOUT);
+    stats_record_game(request->player_name);
     
     printf("Игрок '%s' присоединился к игре '%s' (%d/%d)\n", 
            request->player_name, game->name, 
@@ -191,24 +544,24 @@ void handle_join_game(Message *request, Message *response) {
     response->max_players = game->max_players;
     response->player_count = game->current_players;
     
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
 }
 
-void handle_find_game(Message *request, Message *response) {
-    pthread_mutex_lock(&games_mutex);
+void handle_find_game(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
     
     Game *game = NULL;
-    for (int i = 0; i < game_count; i++) {
-        if (games[i].is_active && 
-            games[i].current_players < games[i].max_players &&
-            !games[i].is_finished) {
-            game = &games[i];
+    for (int i = 0; i < table->game_count; i++) {
+        if (table->games[i].is_active && 
+            table->games[i].current_players < table->games[i].max_players &&
+            !table->games[i].is_finished) {
+            game = &table->games[i];
             break;
         }
     }
     
     if (game == NULL) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Нет доступных игр. Создайте новую игру.");
         return;
@@ -217,7 +570,7 @@ void handle_find_game(Message *request, Message *response) {
     // Проверяем, не присоединился ли игрок уже
     for (int i = 0; i < game->current_players; i++) {
         if (strcmp(game->players[i].name, request->player_name) == 0) {
-            pthread_mutex_unlock(&games_mutex);
+            unlock_games(table);
             response->type = MSG_ERROR;
             strcpy(response->error_msg, "Вы уже в этой игре");
             return;
@@ -225,10 +578,16 @@ void handle_find_game(Message *request, Message *response) {
     }
     
     // Добавляем игрока
+    game_write_begin(game);
     int idx = game->current_players++;
     strcpy(game->players[idx].name, request->player_name);
     game->players[idx].is_active = 1;
     game->players[idx].attempts = 0;
+    game_write_end(game);
+    candidate_set_reset(&game->players[idx].candidates);
+    touch_player(game, &game->players[idx]);
+    timer_schedule(&table->wheel, player_timer_id(table, game, idx), game->last_active + PLAYER_IDLE_TIMEOUT);
+    stats_record_game(request->player_name);
     
     printf("Игрок '%s' автоматически присоединился к игре '%s' (%d/%d)\n", 
            request->player_name, game->name, 
@@ -239,29 +598,29 @@ void handle_find_game(Message *request, Message *response) {
     response->max_players = game->max_players;
     response->player_count = game->current_players;
     
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
 }
 
-void handle_make_guess(Message *request, Message *response) {
-    pthread_mutex_lock(&games_mutex);
+void handle_make_guess(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
     
     Game *game = NULL;
-    for (int i = 0; i < game_count; i++) {
-        if (strcmp(games[i].name, request->game_name) == 0 && games[i].is_active) {
-            game = &games[i];
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, request->game_name) == 0 && table->games[i].is_active) {
+            game = &table->games[i];
             break;
         }
     }
     
     if (game == NULL) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Игра не найдена");
         return;
     }
     
     if (game->is_finished) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         sprintf(response->error_msg, "Игра завершена. Победитель: %s", game->winner);
         return;
@@ -277,7 +636,7 @@ void handle_make_guess(Message *request, Message *response) {
     }
     
     if (player == NULL) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Вы не участвуете в этой игре");
         return;
@@ -285,17 +644,27 @@ void handle_make_guess(Message *request, Message *response) {
     
     // Валидация числа
     if (!is_valid_number(request->guess)) {
-        pthread_mutex_unlock(&games_mutex);
+        unlock_games(table);
         response->type = MSG_ERROR;
         strcpy(response->error_msg, "Неверный формат числа (все цифры должны быть уникальными)");
         return;
     }
     
-    player->attempts++;
-    
     int bulls, cows;
     calculate_bulls_cows(game->secret, request->guess, &bulls, &cows);
     
+    game_write_begin(game);
+    player->attempts++;
+    if (bulls == SECRET_LENGTH) {
+        game->is_finished = 1;
+        strcpy(game->winner, player->name);
+    }
+    game_write_end(game);
+    
+    candidate_set_filter(&player->candidates, request->guess, bulls, cows);
+    touch_player(game, player);
+    uint64_t game_id = game->id;
+    
     printf("Игрок '%s' в игре '%s': попытка %d - %d%d%d%d -> %dБ %dК\n",
            player->name, game->name, player->attempts,
            request->guess[0], request->guess[1], 
@@ -308,12 +677,11 @@ void handle_make_guess(Message *request, Message *response) {
     strcpy(response->result.player_name, player->name);
     
     if (bulls == SECRET_LENGTH) {
-        game->is_finished = 1;
-        strcpy(game->winner, player->name);
         response->type = MSG_GAME_WON;
         response->is_winner = 1;
         printf("*** Игрок '%s' выиграл игру '%s' за %d попыток! ***\n", 
                player->name, game->name, player->attempts);
+        stats_record_win(player->name, player->attempts);
     } else {
         response->type = MSG_GUESS_RESULT;
         response->is_winner = 0;
@@ -321,44 +689,218 @@ void handle_make_guess(Message *request, Message *response) {
     
     strcpy(response->game_name, game->name);
     
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
+    
+    // Запись истории может ждать диска, поэтому после снятия блокировки;
+    // имя и номер попытки уже скопированы в ответ
+    history_record_guess(game_id, response->result.player_name, request->guess,
+                         bulls, cows, response->result.attempt_number);
 }
 
-void handle_list_games(Message *request, Message *response) {
-    pthread_mutex_lock(&games_mutex);
+void handle_leave_game(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
+    
+    Game *game = NULL;
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, request->game_name) == 0 && table->games[i].is_active) {
+            game = &table->games[i];
+            break;
+        }
+    }
+    
+    if (game == NULL) {
+        unlock_games(table);
+        response->type = MSG_ERROR;
+        strcpy(response->error_msg, "Игра не найдена");
+        return;
+    }
+    
+    int idx = -1;
+    for (int i = 0; i < game->current_players; i++) {
+        if (strcmp(game->players[i].name, request->player_name) == 0) {
+            idx = i;
+            break;
+        }
+    }
+    
+    if (idx < 0) {
+        unlock_games(table);
+        response->type = MSG_ERROR;
+        strcpy(response->error_msg, "Вы не участвуете в этой игре");
+        return;
+    }
+    
+    printf("Игрок '%s' покинул игру '%s'\n", request->player_name, game->name);
+    
+    response->type = MSG_LEFT_GAME;
+    strcpy(response->game_name, game->name);
+    remove_player(table, game, idx);
+    response->player_count = game->current_players;
+    
+    unlock_games(table);
+}
+
+void handle_list_games(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
     
     response->type = MSG_GAME_LIST;
     response->game_count = 0;
     
     printf("Запрос списка игр. Активных игр: ");
-    for (int i = 0; i < game_count; i++) {
-        if (games[i].is_active && !games[i].is_finished) {
+    for (int i = 0; i < table->game_count; i++) {
+        if (table->games[i].is_active && !table->games[i].is_finished) {
             response->game_count++;
         }
     }
     printf("%d\n", response->game_count);
     
-    pthread_mutex_unlock(&games_mutex);
+    unlock_games(table);
 }
 
-void process_message(Message *request, Message *response) {
+// Копирует состояние игры по имени без блокировок; 0 если игра не найдена
+int snapshot_game(GameTable *table, const char *name, Message *response) {
+    int count = atomic_load_explicit(&table->game_count, memory_order_acquire);
+    
+    for (int i = 0; i < count; i++) {
+        Game *game = &table->games[i];
+        unsigned seq;
+        int found;
+        
+        do {
+            seq = atomic_load_explicit(&game->seq, memory_order_acquire);
+            if (seq & 1) {
+                found = 0;
+                continue;
+            }
+            
+            found = game->is_active && strncmp(game->name, name, MAX_GAME_NAME) == 0;
+            if (found) {
+                memcpy(response->game_name, game->name, MAX_GAME_NAME);
+                memcpy(response->winner, game->winner, MAX_PLAYER_NAME);
+                response->max_players = game->max_players;
+                response->player_count = game->current_players;
+                response->is_winner = game->is_finished;
+                for (int p = 0; p < MAX_PLAYERS; p++) {
+                    memcpy(response->players[p].name, game->players[p].name, MAX_PLAYER_NAME);
+                    response->players[p].attempts = game->players[p].attempts;
+                }
+            }
+            
+            atomic_thread_fence(memory_order_acquire);
+        } while ((seq & 1) || atomic_load_explicit(&game->seq, memory_order_relaxed) != seq);
+        
+        if (found) {
+            // Копия согласована, но строки могли прийти без завершающего нуля
+            response->game_name[MAX_GAME_NAME - 1] = '\0';
+            response->winner[MAX_PLAYER_NAME - 1] = '\0';
+            if (response->player_count < 0 || response->player_count > MAX_PLAYERS) {
+                response->player_count = 0;
+            }
+            for (int p = 0; p < MAX_PLAYERS; p++) {
+                response->players[p].name[MAX_PLAYER_NAME - 1] = '\0';
+                if (p >= response->player_count) {
+                    memset(&response->players[p], 0, sizeof(PlayerInfo));
+                }
+            }
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+void handle_game_state(GameTable *table, Message *request, Message *response) {
+    if (!snapshot_game(table, request->game_name, response)) {
+        response->type = MSG_ERROR;
+        strcpy(response->error_msg, "Игра не найдена");
+        return;
+    }
+    
+    response->type = MSG_GAME_STATE;
+}
+
+void handle_get_hint(GameTable *table, Message *request, Message *response) {
+    lock_games(table);
+    
+    Game *game = NULL;
+    for (int i = 0; i < table->game_count; i++) {
+        if (strcmp(table->games[i].name, request->game_name) == 0 && table->games[i].is_active) {
+            game = &table->games[i];
+            break;
+        }
+    }
+    
+    if (game == NULL) {
+        unlock_games(table);
+        response->type = MSG_ERROR;
+        strcpy(response->error_msg, "Игра не найдена");
+        return;
+    }
+    
+    Player *player = NULL;
+    for (int i = 0; i < game->current_players; i++) {
+        if (strcmp(game->players[i].name, request->player_name) == 0) {
+            player = &game->players[i];
+            break;
+        }
+    }
+    
+    if (player == NULL) {
+        unlock_games(table);
+        response->type = MSG_ERROR;
+        strcpy(response->error_msg, "Вы не участвуете в этой игре");
+        return;
+    }
+    
+    // Множество уже сужено в handle_make_guess, здесь только чтение
+    touch_player(game, player);
+    response->type = MSG_HINT;
+    response->candidates_left = player->candidates.count;
+    candidate_set_nth(&player->candidates, 0, response->guess);
+    strcpy(response->game_name, game->name);
+    
+    unlock_games(table);
+}
+
+void handle_get_leaderboard(Message *request, Message *response) {
+    response->type = MSG_LEADERBOARD;
+    response->player_count = leaderboard_top(response->leaders, LEADERBOARD_SIZE);
+    
+    if (!stats_lookup(request->player_name, &response->stats)) {
+        strcpy(response->stats.name, request->player_name);
+    }
+}
+
+void process_message(GameTable *table, Message *request, Message *response) {
     init_message(response);
     
     switch (request->type) {
         case MSG_CREATE_GAME:
-            handle_create_game(request, response);
+            handle_create_game(table, request, response);
             break;
         case MSG_JOIN_GAME:
-            handle_join_game(request, response);
+            handle_join_game(table, request, response);
             break;
         case MSG_FIND_GAME:
-            handle_find_game(request, response);
+            handle_find_game(table, request, response);
             break;
         case MSG_MAKE_GUESS:
-            handle_make_guess(request, response);
+            handle_make_guess(table, request, response);
+            break;
+        case MSG_LEAVE_GAME:
+            handle_leave_game(table, request, response);
             break;
         case MSG_LIST_GAMES:
-            handle_list_games(request, response);
+            handle_list_games(table, request, response);
+            break;
+        case MSG_GET_LEADERBOARD:
+            handle_get_leaderboard(request, response);
+            break;
+        case MSG_GET_HINT:
+            handle_get_hint(table, request, response);
+            break;
+        case MSG_GAME_STATE:
+            handle_game_state(table, request, response);
             break;
         default:
             response->type = MSG_ERROR;
@@ -370,106 +912,421 @@ void process_message(Message *request, Message *response) {
 // Обработчик клиента в отдельном потоке
 void* handle_client(void* arg) {
     ClientRequest *client_req = (ClientRequest*)arg;
-    Message response;
+    Message *request = client_req->request;
     
-    // Обрабатываем запрос
-    process_message(&client_req->request, &response);
+    PROF_BEGIN(request->type);
+    PROF_RECORD(PROF_DISPATCH, client_req->t_recv);
     
-    // Отправляем ответ обратно через ROUTER сокет
-    zmq_send(client_req->socket, client_req->identity, client_req->identity_size, ZMQ_SNDMORE);
-    zmq_send(client_req->socket, "", 0, ZMQ_SNDMORE);
+    // Обрабатываем запрос прямо в буфере ZeroMQ
+    PROF_TIMESTAMP(t_handler);
+    process_message(served_table, request, &client_req->response);
+    PROF_RECORD(PROF_HANDLER, t_handler);
+    PROF_THREAD_EXIT();
     
-    // Сериализуем и отправляем ответ
-    size_t msg_size = sizeof(Message);
-    zmq_send(client_req->socket, &response, msg_size, 0);
+    zmq_msg_close(&client_req->body);
+    complete_request(client_req);
     
-    free(client_req);
+    // После этого поток больше не трогает eventfd, пул и таблицу
+    atomic_fetch_sub(&live_handlers, 1);
     return NULL;
 }
 
-int main() {
-    printf("========================================\n");
-    printf("Сервер игры 'Быки и Коровы' (многопоточный)\n");
-    printf("========================================\n\n");
+// Принимает один запрос и запускает его обработку.
+// Возвращает 0, если сообщений больше нет, -1 при фатальной ошибке.
+int receive_request(void *socket) {
+    ClientRequest *client_req = pool_get();
+    if (!client_req) {
+        printf("Ошибка выделения памяти\n");
+        return 0;
+    }
     
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    // Получаем identity клиента
+    zmq_msg_init(&client_req->identity);
+    if (zmq_msg_recv(&client_req->identity, socket, ZMQ_DONTWAIT) == -1) {
+        int err = zmq_errno();
+        zmq_msg_close(&client_req->identity);
+        pool_put(client_req);
+        // Очередь пуста или прерывание сигналом (SIGUSR1 при профилировании)
+        if (err == EAGAIN || err == EINTR) {
+            return 0;
+        }
+        printf("Ошибка получения identity: %s\n", zmq_strerror(err));
+        return -1;
+    }
     
-    global_context = zmq_ctx_new();
-    void *socket = zmq_socket(global_context, ZMQ_ROUTER);
+    // Пропускаем разделитель
+    PROF_TIMESTAMP(t_recv);
+    zmq_msg_t delimiter;
+    zmq_msg_init(&delimiter);
+    int rc = zmq_msg_recv(&delimiter, socket, 0);
+    zmq_msg_close(&delimiter);
+    if (rc == -1) {
+        printf("Ошибка получения разделителя: %s\n", zmq_strerror(errno));
+        zmq_msg_close(&client_req->identity);
+        pool_put(client_req);
+        return 1;
+    }
     
-    int rc = zmq_bind(socket, SERVER_ENDPOINT);
-    if (rc != 0) {
-        printf("Ошибка привязки сокета: %s\n", zmq_strerror(errno));
+    // Получаем сообщение
+    zmq_msg_init(&client_req->body);
+    rc = zmq_msg_recv(&client_req->body, socket, 0);
+    if (rc == -1 || zmq_msg_size(&client_req->body) != sizeof(Message)) {
+        if (rc == -1) {
+            printf("Ошибка получения сообщения: %s\n", zmq_strerror(errno));
+        } else {
+            printf("Сообщение неверного размера: %d байт\n", rc);
+        }
+        zmq_msg_close(&client_req->body);
+        zmq_msg_close(&client_req->identity);
+        pool_put(client_req);
         return 1;
     }
     
-    printf("Сервер запущен на %s\n", SERVER_ENDPOINT);
-    printf("Режим: многопоточный (до %d потоков)\n", MAX_THREADS);
-    printf("Ожидание подключений...\n\n");
+    void *data = zmq_msg_data(&client_req->body);
+    if ((uintptr_t)data % _Alignof(Message) == 0) {
+        client_req->request = (Message*)data;
+    } else {
+        memcpy(&client_req->aligned_request, data, sizeof(Message));
+        client_req->request = &client_req->aligned_request;
+    }
+    
+    PROF_SET_TIMESTAMP(client_req->t_recv);
+#ifdef SERVER_PROFILE
+    client_req->request_type = client_req->request->type;
+#endif
+    
+    // Время приёма записывается в гистограммы основного потока
+    PROF_BEGIN(client_req->request_type);
+    PROF_RECORD(PROF_RECV, t_recv);
+    
+    // Создаем новый поток для обработки запроса
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    
+    atomic_fetch_add(&in_flight, 1);
+    atomic_fetch_add(&live_handlers, 1);
+    if (pthread_create(&thread, &attr, handle_client, client_req) != 0) {
+        printf("Ошибка создания потока\n");
+        atomic_fetch_sub(&in_flight, 1);
+        atomic_fetch_sub(&live_handlers, 1);
+        zmq_msg_close(&client_req->body);
+        zmq_msg_close(&client_req->identity);
+        pool_put(client_req);
+    }
+    
+    pthread_attr_destroy(&attr);
+    return 1;
+}
+
+// Освобождает endpoint для нового процесса, когда запросов в обработке
+// нет и новые не приходили HANDOVER_QUIET_MS; 1 - endpoint освобождён
+int finish_handover(void *socket, long drain_start, long last_activity) {
+    long now = monotonic_ms();
+    
+    if (now - drain_start < HANDOVER_MAX_MS &&
+        (atomic_load(&in_flight) > 0 || now - last_activity < HANDOVER_QUIET_MS)) {
+        return 0;
+    }
+    
+    // Для unbind нужен фактический адрес, а не "tcp://*:5555"
+    char endpoint[256];
+    size_t size = sizeof(endpoint);
+    if (zmq_getsockopt(socket, ZMQ_LAST_ENDPOINT, endpoint, &size) == 0) {
+        zmq_unbind(socket, endpoint);
+    }
+    printf("Endpoint передан новому процессу, дообработано за %ld мс\n", now - drain_start);
+    handed_over = 1;
+    return 1;
+}
+
+// Потоки обработки отсоединены: при остановке дожидаемся их, отправляя
+// готовые ответы. 0 - не дождались за SHUTDOWN_WAIT_MS.
+int wait_handlers(void *socket) {
+    zmq_pollitem_t item = { NULL, completion_fd, ZMQ_POLLIN, 0 };
+    long start = monotonic_ms();
+    
+    while (atomic_load(&live_handlers) > 0 && monotonic_ms() - start < SHUTDOWN_WAIT_MS) {
+        if (zmq_poll(&item, 1, 10) > 0 && (item.revents & ZMQ_POLLIN)) {
+            send_completed(socket);
+        }
+    }
+    send_completed(socket);
+    
+    return atomic_load(&live_handlers) == 0;
+}
+
+// Многопоточный режим: общая таблица, поток на каждый запрос.
+// При gateway_port > 0 в ту же таблицу обслуживает запросы TCP-шлюз;
+// wait_port - порт шлюза ещё держит прежний процесс (--shm).
+int run_threaded(GameTable *table, void *socket, int gateway_port, int wait_port) {
+    completion_fd = eventfd(0, EFD_NONBLOCK);
+    if (completion_fd == -1) {
+        printf("Ошибка создания eventfd: %s\n", strerror(errno));
+        return 1;
+    }
+    
+    served_table = table;
+    pthread_t timer_tid;
+    if (pthread_create(&timer_tid, NULL, timer_thread, table) != 0) {
+        printf("Ошибка создания потока таймеров\n");
+        return 1;
+    }
     
-    // Установка таймаута для recv
-    int timeout = 1000; // 1 секунда
-    zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+    if (gateway_port > 0 && gateway_start(table, gateway_port, wait_port) != 0) {
+        running = 0;
+        pthread_join(timer_tid, NULL);
+        return 1;
+    }
+    
+    zmq_pollitem_t items[] = {
+        { socket, 0, ZMQ_POLLIN, 0 },
+        { NULL, completion_fd, ZMQ_POLLIN, 0 }
+    };
     
+    int rc = 0, status = 0;
+    long drain_start = 0, last_activity = 0;
     while (running) {
-        ClientRequest *client_req = malloc(sizeof(ClientRequest));
-        if (!client_req) {
-            printf("Ошибка выделения памяти\n");
-            continue;
+        PROF_POLL();
+        
+        if (handover_requested && drain_start == 0) {
+            printf("Новый процесс запрашивает endpoint, дообрабатываем запросы...\n");
+            drain_start = last_activity = monotonic_ms();
         }
         
-        // Получаем identity клиента
-        client_req->identity_size = zmq_recv(socket, client_req->identity, 256, 0);
-        if (client_req->identity_size == -1) {
-            if (zmq_errno() == EAGAIN) {
-                free(client_req);
+        // Таймаут 1 секунда, чтобы проверять флаг running
+        if (zmq_poll(items, 2, drain_start ? 10 : 1000) == -1) {
+            if (zmq_errno() == EINTR) {
                 continue;
             }
-            printf("Ошибка получения identity: %s\n", zmq_strerror(errno));
-            free(client_req);
+            printf("Ошибка zmq_poll: %s\n", zmq_strerror(zmq_errno()));
             break;
         }
         
-        // Пропускаем разделитель
-        char delimiter[10];
-        rc = zmq_recv(socket, delimiter, 10, 0);
-        if (rc == -1) {
-            printf("Ошибка получения разделителя: %s\n", zmq_strerror(errno));
-            free(client_req);
-            continue;
+        if (items[1].revents & ZMQ_POLLIN) {
+            send_completed(socket);
         }
         
-        // Получаем сообщение
-        size_t msg_size = sizeof(Message);
-        rc = zmq_recv(socket, &client_req->request, msg_size, 0);
-        if (rc == -1) {
-            printf("Ошибка получения сообщения: %s\n", zmq_strerror(errno));
-            free(client_req);
-            continue;
+        if (items[0].revents & ZMQ_POLLIN) {
+            // Ограничиваем пачку, чтобы не задерживать отправку ответов
+            for (int i = 0; i < RECV_BATCH; i++) {
+                if ((rc = receive_request(socket)) <= 0) {
+                    break;
+                }
+            }
+            if (rc < 0) {
+                status = 1;
+                break;
+            }
         }
         
-        client_req->socket = socket;
-        
-        // Создаем новый поток для обработки запроса
-        pthread_t thread;
-        pthread_attr_t attr;
-        pthread_attr_init(&attr);
-        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-        
-        if (pthread_create(&thread, &attr, handle_client, client_req) != 0) {
-            printf("Ошибка создания потока\n");
-            free(client_req);
+        if (drain_start) {
+            if (items[0].revents || items[1].revents) {
+                last_activity = monotonic_ms();
+            }
+            if (finish_handover(socket, drain_start, last_activity)) {
+                break;
+            }
         }
-        
-        pthread_attr_destroy(&attr);
+    }
+    
+    running = 0;
+    if (gateway_port > 0) {
+        gateway_stop();
+    }
+    pthread_join(timer_tid, NULL);
+    
+    // Зависший обработчик ещё может обратиться к eventfd и mutex,
+    // поэтому тогда ничего не освобождаем - процесс всё равно завершается
+    if (!wait_handlers(socket)) {
+        printf("Обработчики не завершились за %d мс\n", SHUTDOWN_WAIT_MS);
+        return 1;
+    }
+    close(completion_fd);
+    if (table->shared == TABLE_THREADS) {
+        pthread_mutex_destroy(&table->mutex);
+    }
+    return status;
+}
+
+// Режим симуляции: server --simulate <random|first> <игр> [потоков] [--seed N]
+int run_simulate_mode(int argc, char *argv[]) {
+    SimStrategy strategy;
+    int threads = 0;
+    
+    // --seed может стоять и до, и после числа потоков
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            prng_set_seed(strtoull(argv[++i], NULL, 10));
+        } else if (argv[i][0] != '-' && threads == 0) {
+            threads = atoi(argv[i]);
+        } else {
+            printf("Неизвестный параметр: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (argc < 4 || !parse_strategy(argv[2], &strategy)) {
+        printf("Использование: %s --simulate <random|first> <количество игр> [потоков] [--seed N]\n", argv[0]);
+        return 1;
+    }
+    
+    long games = atol(argv[3]);
+    if (games <= 0) {
+        printf("Количество игр должно быть положительным\n");
+        return 1;
+    }
+    
+    SimResult result;
+    threads = run_simulation(strategy, games, threads, &result);
+    if (threads < 0) {
+        printf("Ошибка выделения памяти\n");
+        return 1;
+    }
+    
+    print_simulation_result(strategy, threads, &result);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--simulate") == 0) {
+        return run_simulate_mode(argc, argv);
+    }
+    
+    // --shards N: таблица игр делится на N потоков
+    // --gateway [порт]: TCP-шлюз без ZeroMQ (по умолчанию порт GATEWAY_PORT)
+    // --history [каталог]: запись попыток в колоночные файлы
+    // --shm [имя]: таблица игр в разделяемой памяти, перезапуск без потери игр
+    // --seed N: воспроизводимые секреты для замеров и повторов
+    int shard_count = 0;
+    int gateway_port = 0;
+    const char *history_dir = NULL;
+    const char *store_name = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shard_count = atoi(argv[++i]);
+            if (shard_count < 1) {
+                printf("Количество шардов должно быть положительным\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--gateway") == 0) {
+            gateway_port = GATEWAY_PORT;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                gateway_port = atoi(argv[++i]);
+            }
+            if (gateway_port < 1 || gateway_port > 65535) {
+                printf("Неверный порт шлюза\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--history") == 0) {
+            history_dir = HISTORY_DIR;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                history_dir = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            prng_set_seed(strtoull(argv[++i], NULL, 10));
+        } else if (strcmp(argv[i], "--shm") == 0) {
+            store_name = GAME_STORE_NAME;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                store_name = argv[++i];
+            }
+        } else {
+            printf("Неизвестный параметр: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (shard_count > 0 && (gateway_port > 0 || store_name)) {
+        printf("TCP-шлюз и --shm работают только в многопоточном режиме\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("Сервер игры 'Быки и Коровы' (многопоточный)\n");
+    printf("========================================\n\n");
+    
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    PROF_INSTALL();
+    
+    // Подключаемся к играм прежнего процесса и просим его освободить endpoint
+    GameStore *store = NULL;
+    int previous_owner = 0;
+    if (store_name) {
+        store = game_store_attach(store_name, &previous_owner);
+        if (!store) {
+            return 1;
+        }
+        signal(SIGUSR2, handover_handler);
+        if (previous_owner) {
+            printf("Запрашиваем endpoint у процесса %d\n", previous_owner);
+            kill(previous_owner, SIGUSR2);
+        }
+    } else if (shard_count == 0) {
+        game_table_init(&game_table, TABLE_THREADS);
+    }
+    
+    global_context = zmq_ctx_new();
+    void *socket = zmq_socket(global_context, ZMQ_ROUTER);
+    
+#ifdef ZMQ_HEARTBEAT_IVL
+    // Пинги ZeroMQ разрывают соединения с пропавшими клиентами; их места
+    // в играх освобождает таймер простоя
+    int heartbeat_ivl = HEARTBEAT_IVL;
+    int heartbeat_timeout = HEARTBEAT_TIMEOUT;
+    zmq_setsockopt(socket, ZMQ_HEARTBEAT_IVL, &heartbeat_ivl, sizeof(heartbeat_ivl));
+    zmq_setsockopt(socket, ZMQ_HEARTBEAT_TIMEOUT, &heartbeat_timeout, sizeof(heartbeat_timeout));
+#endif
+    
+    long bind_start = monotonic_ms();
+    int rc = zmq_bind(socket, SERVER_ENDPOINT);
+    while (rc != 0 && zmq_errno() == EADDRINUSE && previous_owner &&
+           monotonic_ms() - bind_start < BIND_RETRY_MS) {
+        usleep(1000);
+        rc = zmq_bind(socket, SERVER_ENDPOINT);
+    }
+    if (rc != 0) {
+        printf("Ошибка привязки сокета: %s\n", zmq_strerror(errno));
+        return 1;
+    }
+    if (store) {
+        game_store_set_owner(store);
+        if (previous_owner) {
+            printf("Endpoint получен от процесса %d за %ld мс\n",
+                   previous_owner, monotonic_ms() - bind_start);
+        }
+    }
+    
+    if (history_dir && history_open(history_dir) != 0) {
+        return 1;
+    }
+    
+    printf("Сервер запущен на %s\n", SERVER_ENDPOINT);
+    if (shard_count > 0) {
+        printf("Режим: шарды (%d потоков без блокировок)\n", shard_count);
+    } else {
+        printf("Режим: многопоточный (до %d потоков)\n", MAX_THREADS);
+    }
+    printf("Ожидание подключений...\n\n");
+    
+    if (shard_count > 0) {
+        rc = run_sharded(global_context, socket, shard_count);
+    } else {
+        rc = run_threaded(store ? &store->table : &game_table, socket, gateway_port,
+                          previous_owner != 0);
     }
     
     printf("\nЗакрытие сервера...\n");
     zmq_close(socket);
     zmq_ctx_destroy(global_context);
-    pthread_mutex_destroy(&games_mutex);
+    if (atomic_load(&live_handlers) == 0) {
+        pool_destroy();
+    }
+    history_close();
+    if (store) {
+        // После передачи игры остаются новому процессу
+        game_store_detach(store, store_name, !handed_over);
+    }
     
     printf("Сервер остановлен.\n");
-    return 0;
+    return rc;
 }
@@ -0,0 +1,62 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "common.h"
+#include "candidates.h"
+#include "timer_wheel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Структура игрока
+typedef struct {
+    char name[MAX_PLAYER_NAME];
+    int is_active;
+    int attempts;
+    uint32_t last_active;       // время последнего запроса, server_now()
+    CandidateSet candidates;    // числа, совместимые с ответами игроку
+} Player;
+
+// Структура игры
+typedef struct {
+    char name[MAX_GAME_NAME];
+    uint64_t id;                // номер игры в истории попыток
+    int secret[SECRET_LENGTH];
+    int max_players;
+    int current_players;
+    Player players[MAX_PLAYERS];
+    int is_active;
+    int is_finished;
+    char winner[MAX_PLAYER_NAME];
+    uint32_t last_active;
+    atomic_uint seq;            // seqlock: нечётное значение - идёт запись
+} Game;
+
+// Кто работает с таблицей игр (поле shared)
+#define TABLE_LOCAL 0           // один поток шарда, без блокировок
+#define TABLE_THREADS 1         // потоки одного процесса
+#define TABLE_PROCESSES 2       // разделяемая память, переживает перезапуск
+
+// Таблица игр. В многопоточном режиме одна общая под mutex, в режиме
+// шардов у каждого потока своя и без блокировок. Внутри нет указателей,
+// поэтому её можно разместить в разделяемой памяти (game_store.h).
+typedef struct {
+    Game games[MAX_GAMES];
+    atomic_int game_count;      // читается без блокировки в handle_game_state
+    int shared;
+    pthread_mutex_t mutex;
+    TimerWheel wheel;           // под mutex
+} GameTable;
+
+extern int running;
+
+uint32_t server_now(void);
+long monotonic_ms(void);
+void game_table_init(GameTable *table, int shared);
+void game_table_tick(GameTable *table);
+void process_message(GameTable *table, Message *request, Message *response);
+void handle_get_leaderboard(Message *request, Message *response);
+
+// Режим шардов (shard.c)
+int run_sharded(void *context, void *socket, int shard_count);
+
+#endif // SERVER_H
@@ -0,0 +1,452 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include "profile.h"
+#include <stddef.h>
+#include <unistd.h>
+#include <sched.h>
+
+#define SHARD_MAX 64
+#define SHARD_BATCH 64
+
+// Шард владеет своей таблицей игр и обрабатывает её в одном потоке без
+// блокировок. Основной поток видит только сводку, которую шард
+// публикует после каждой пачки запросов.
+typedef struct {
+    int id;
+    void *context;
+    void *pipe;                 // PAIR-сокет основного потока
+    GameTable *table;
+    pthread_t thread;
+    atomic_int listed_games;    // активные незавершённые игры
+    atomic_int open_games;      // из них есть свободные места
+    char pad[64];
+} Shard;
+
+static void publish_summary(Shard *shard) {
+    GameTable *table = shard->table;
+    int listed = 0, open = 0;
+
+    for (int i = 0; i < table->game_count; i++) {
+        Game *game = &table->games[i];
+        if (game->is_active && !game->is_finished) {
+            listed++;
+            if (game->current_players < game->max_players) {
+                open++;
+            }
+        }
+    }
+
+    atomic_store_explicit(&shard->listed_games, listed, memory_order_relaxed);
+    atomic_store_explicit(&shard->open_games, open, memory_order_relaxed);
+}
+
+// Обрабатывает один запрос из канала; 0 - канал пуст
+static int shard_serve_one(Shard *shard, void *pipe) {
+    zmq_msg_t identity, body, reply;
+
+    zmq_msg_init(&identity);
+    if (zmq_msg_recv(&identity, pipe, ZMQ_DONTWAIT) == -1) {
+        zmq_msg_close(&identity);
+        return 0;
+    }
+    zmq_msg_init(&body);
+    if (zmq_msg_recv(&body, pipe, 0) == -1) {
+        zmq_msg_close(&body);
+        zmq_msg_close(&identity);
+        return 0;
+    }
+
+    // Подбор игры приходит с кадром шарда, с которого начался поиск
+    int origin = -1;
+    if (zmq_msg_more(&body)) {
+        memcpy(&origin, zmq_msg_data(&body), sizeof(origin));
+        zmq_msg_close(&body);
+        zmq_msg_init(&body);
+        if (zmq_msg_recv(&body, pipe, 0) == -1) {
+            zmq_msg_close(&body);
+            zmq_msg_close(&identity);
+            return 0;
+        }
+    }
+
+    // Шард выбран по устаревшей сводке и свободных мест в нём уже нет:
+    // запрос возвращается основному потоку для следующего шарда
+    if (origin >= 0) {
+        publish_summary(shard);
+        if (atomic_load_explicit(&shard->open_games, memory_order_relaxed) == 0) {
+            zmq_msg_send(&identity, pipe, ZMQ_SNDMORE);
+            zmq_send(pipe, &origin, sizeof(origin), ZMQ_SNDMORE);
+            zmq_msg_send(&body, pipe, 0);
+            return 1;
+        }
+    }
+
+    Message aligned_request, aligned_response;
+    Message *request = (Message*)zmq_msg_data(&body);
+    if ((uintptr_t)request % _Alignof(Message) != 0) {
+        memcpy(&aligned_request, request, sizeof(Message));
+        request = &aligned_request;
+    }
+
+    // Ответ пишется сразу в буфер сообщения, который уйдёт клиенту
+    zmq_msg_init_size(&reply, sizeof(Message));
+    Message *response = (Message*)zmq_msg_data(&reply);
+    if ((uintptr_t)response % _Alignof(Message) != 0) {
+        response = &aligned_response;
+    }
+
+    PROF_BEGIN(request->type);
+    PROF_TIMESTAMP(t_handler);
+    process_message(shard->table, request, response);
+    PROF_RECORD(PROF_HANDLER, t_handler);
+
+    if (response == &aligned_response) {
+        memcpy(zmq_msg_data(&reply), response, sizeof(Message));
+    }
+    zmq_msg_close(&body);
+
+    zmq_msg_send(&identity, pipe, ZMQ_SNDMORE);
+    zmq_msg_send(&reply, pipe, 0);
+    return 1;
+}
+
+static void* shard_thread(void *arg) {
+    Shard *shard = (Shard*)arg;
+    char endpoint[64];
+
+    // Поток привязан к своему ядру, а таблицу заполняет уже на нём,
+    // чтобы её страницы оказались в локальной памяти
+    cpu_set_t cpus;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    CPU_ZERO(&cpus);
+    CPU_SET(shard->id % (ncpu > 0 ? ncpu : 1), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    shard->table = malloc(sizeof(GameTable));
+    if (!shard->table) {
+        printf("Ошибка выделения памяти для шарда %d\n", shard->id);
+        running = 0;
+        return NULL;
+    }
+    game_table_init(shard->table, TABLE_LOCAL);
+
+    void *pipe = zmq_socket(shard->context, ZMQ_PAIR);
+    snprintf(endpoint, sizeof(endpoint), "inproc://shard-%d", shard->id);
+    zmq_connect(pipe, endpoint);
+
+    zmq_pollitem_t item = { pipe, 0, ZMQ_POLLIN, 0 };
+    uint32_t last_tick = server_now();
+
+    while (running) {
+        if (zmq_poll(&item, 1, 1000) == -1 && zmq_errno() != EINTR) {
+            break;
+        }
+
+        if (item.revents & ZMQ_POLLIN) {
+            for (int i = 0; i < SHARD_BATCH; i++) {
+                if (!shard_serve_one(shard, pipe)) {
+                    break;
+                }
+            }
+        }
+
+        // Таймеры простоя шард проверяет сам, раз в секунду
+        uint32_t now = server_now();
+        if (now != last_tick) {
+            game_table_tick(shard->table);
+            last_tick = now;
+        }
+
+        publish_summary(shard);
+    }
+
+    PROF_THREAD_EXIT();
+    zmq_close(pipe);
+    return NULL;
+}
+
+// Ответ клиенту от имени основного потока
+static void send_reply(void *socket, zmq_msg_t *identity, Message *response) {
+    zmq_msg_send(identity, socket, ZMQ_SNDMORE);
+    zmq_send(socket, "", 0, ZMQ_SNDMORE);
+    zmq_send(socket, response, sizeof(Message), 0);
+}
+
+static void send_no_games(void *socket, zmq_msg_t *identity) {
+    Message response;
+
+    init_message(&response);
+    response.type = MSG_ERROR;
+    strcpy(response.error_msg, "Нет доступных игр. Создайте новую игру.");
+    send_reply(socket, identity, &response);
+}
+
+// Первый по кругу шард со свободными местами, начиная с first и до
+// origin (не включая его, если first != origin); -1 - таких нет
+static int find_open_shard(Shard *shards, int shard_count, int first, int origin) {
+    int i = first;
+
+    do {
+        if (atomic_load_explicit(&shards[i].open_games, memory_order_relaxed) > 0) {
+            return i;
+        }
+        i = (i + 1) % shard_count;
+    } while (i != origin);
+    return -1;
+}
+
+// Выбирает шард для запроса; -1 - ответ уже отправлен основным потоком.
+// Для подбора игры в origin - шард, с которого начат обход.
+static int route_request(Shard *shards, int shard_count, void *socket,
+                         zmq_msg_t *identity, zmq_msg_t *body, int *origin) {
+    static int next_find = 0;
+    const char *data = (const char*)zmq_msg_data(body);
+    MessageType type;
+    Message response;
+
+    memcpy(&type, data + offsetof(Message, type), sizeof(type));
+
+    switch (type) {
+        case MSG_LIST_GAMES:
+            // Список собирается из сводок шардов, без обращения к ним
+            init_message(&response);
+            response.type = MSG_GAME_LIST;
+            for (int i = 0; i < shard_count; i++) {
+                response.game_count += atomic_load_explicit(&shards[i].listed_games, memory_order_relaxed);
+            }
+            send_reply(socket, identity, &response);
+            return -1;
+
+        case MSG_GET_LEADERBOARD: {
+            // Статистика общая для всех шардов и защищена своим mutex
+            Message request;
+            memcpy(&request, data, sizeof(Message));
+            init_message(&response);
+            handle_get_leaderboard(&request, &response);
+            send_reply(socket, identity, &response);
+            return -1;
+        }
+
+        case MSG_FIND_GAME: {
+            // Подбор игры: первый по кругу шард со свободными местами. Если
+            // сводка устарела, шард вернёт запрос и обход продолжится.
+            int i = find_open_shard(shards, shard_count, next_find, next_find);
+            if (i < 0) {
+                send_no_games(socket, identity);
+                return -1;
+            }
+            *origin = next_find;
+            next_find = (i + 1) % shard_count;
+            return i;
+        }
+
+        default:
+            return hash_name(data + offsetof(Message, game_name), MAX_GAME_NAME) % shard_count;
+    }
+}
+
+// Принимает запрос клиента и передаёт его шарду.
+// Возвращает 0, если сообщений больше нет, -1 при фатальной ошибке.
+static int dispatch_request(Shard *shards, int shard_count, void *socket) {
+    zmq_msg_t identity, delimiter, body;
+
+    zmq_msg_init(&identity);
+    if (zmq_msg_recv(&identity, socket, ZMQ_DONTWAIT) == -1) {
+        int err = zmq_errno();
+        zmq_msg_close(&identity);
+        if (err == EAGAIN || err == EINTR) {
+            return 0;
+        }
+        printf("Ошибка получения identity: %s\n", zmq_strerror(err));
+        return -1;
+    }
+
+    PROF_TIMESTAMP(t_recv);
+    zmq_msg_init(&delimiter);
+    int rc = zmq_msg_recv(&delimiter, socket, 0);
+    zmq_msg_close(&delimiter);
+    if (rc == -1) {
+        printf("Ошибка получения разделителя: %s\n", zmq_strerror(errno));
+        zmq_msg_close(&identity);
+        return 1;
+    }
+
+    zmq_msg_init(&body);
+    rc = zmq_msg_recv(&body, socket, 0);
+    if (rc == -1 || zmq_msg_size(&body) != sizeof(Message)) {
+        if (rc == -1) {
+            printf("Ошибка получения сообщения: %s\n", zmq_strerror(errno));
+        } else {
+            printf("Сообщение неверного размера: %d байт\n", rc);
+        }
+        zmq_msg_close(&body);
+        zmq_msg_close(&identity);
+        return 1;
+    }
+
+    int origin = -1;
+    int target = route_request(shards, shard_count, socket, &identity, &body, &origin);
+    if (target >= 0) {
+        // Кадры передаются шарду без копирования
+        zmq_msg_send(&identity, shards[target].pipe, ZMQ_SNDMORE);
+        if (origin >= 0) {
+            zmq_send(shards[target].pipe, &origin, sizeof(origin), ZMQ_SNDMORE);
+        }
+        zmq_msg_send(&body, shards[target].pipe, 0);
+    }
+    PROF_RECORD(PROF_RECV, t_recv);
+
+    zmq_msg_close(&body);
+    zmq_msg_close(&identity);
+    return 1;
+}
+
+// Передаёт возвращённый шардом index подбор игры следующему шарду
+// со свободными местами; обошли круг до origin - мест нет
+static void retry_find(Shard *shards, int shard_count, int index, void *socket,
+                       zmq_msg_t *identity, zmq_msg_t *origin_frame) {
+    zmq_msg_t body;
+    int origin;
+
+    memcpy(&origin, zmq_msg_data(origin_frame), sizeof(origin));
+    zmq_msg_init(&body);
+    zmq_msg_recv(&body, shards[index].pipe, 0);
+
+    int first = (index + 1) % shard_count;
+    int next = first == origin ? -1 : find_open_shard(shards, shard_count, first, origin);
+    if (next >= 0) {
+        zmq_msg_send(identity, shards[next].pipe, ZMQ_SNDMORE);
+        zmq_send(shards[next].pipe, &origin, sizeof(origin), ZMQ_SNDMORE);
+        zmq_msg_send(&body, shards[next].pipe, 0);
+    } else {
+        send_no_games(socket, identity);
+    }
+    zmq_msg_close(&body);
+}
+
+// Пересылает клиенту ответ шарда index; 0 - ответов больше нет
+static int forward_reply(Shard *shards, int shard_count, int index, void *socket) {
+    void *pipe = shards[index].pipe;
+    zmq_msg_t identity, reply;
+
+    zmq_msg_init(&identity);
+    if (zmq_msg_recv(&identity, pipe, ZMQ_DONTWAIT) == -1) {
+        zmq_msg_close(&identity);
+        return 0;
+    }
+    zmq_msg_init(&reply);
+    zmq_msg_recv(&reply, pipe, 0);
+
+    if (zmq_msg_more(&reply)) {
+        retry_find(shards, shard_count, index, socket, &identity, &reply);
+        zmq_msg_close(&reply);
+        zmq_msg_close(&identity);
+        return 1;
+    }
+
+    PROF_TIMESTAMP(t_send);
+    zmq_msg_send(&identity, socket, ZMQ_SNDMORE);
+    zmq_send(socket, "", 0, ZMQ_SNDMORE);
+    zmq_msg_send(&reply, socket, 0);
+    PROF_RECORD(PROF_SEND, t_send);
+
+    zmq_msg_close(&reply);
+    zmq_msg_close(&identity);
+    return 1;
+}
+
+// Режим шардов: таблица игр делится между shard_count потоками по хешу
+// имени игры. Основной поток только принимает кадры и раздаёт их шардам
+// через inproc-каналы.
+int run_sharded(void *context, void *socket, int shard_count) {
+    if (shard_count > SHARD_MAX) shard_count = SHARD_MAX;
+
+    Shard *shards = calloc(shard_count, sizeof(Shard));
+    zmq_pollitem_t *items = calloc(shard_count + 1, sizeof(zmq_pollitem_t));
+    if (!shards || !items) {
+        printf("Ошибка выделения памяти\n");
+        free(shards);
+        free(items);
+        return 1;
+    }
+
+    int started = 0;
+    for (int i = 0; i < shard_count; i++) {
+        char endpoint[64];
+        Shard *shard = &shards[i];
+
+        shard->id = i;
+        shard->context = context;
+
+        // Канал привязывается до старта потока, который к нему подключится
+        shard->pipe = zmq_socket(context, ZMQ_PAIR);
+        snprintf(endpoint, sizeof(endpoint), "inproc://shard-%d", i);
+        if (zmq_bind(shard->pipe, endpoint) != 0) {
+            printf("Ошибка привязки %s: %s\n", endpoint, zmq_strerror(errno));
+            break;
+        }
+
+        if (pthread_create(&shard->thread, NULL, shard_thread, shard) != 0) {
+            printf("Ошибка создания потока шарда\n");
+            break;
+        }
+        started++;
+    }
+
+    int rc = started == shard_count ? 0 : 1;
+
+    items[0].socket = socket;
+    items[0].events = ZMQ_POLLIN;
+    for (int i = 0; i < started; i++) {
+        items[i + 1].socket = shards[i].pipe;
+        items[i + 1].events = ZMQ_POLLIN;
+    }
+
+    while (running && rc == 0) {
+        PROF_POLL();
+
+        if (zmq_poll(items, shard_count + 1, 1000) == -1) {
+            if (zmq_errno() == EINTR) {
+                continue;
+            }
+            printf("Ошибка zmq_poll: %s\n", zmq_strerror(zmq_errno()));
+            break;
+        }
+
+        for (int i = 0; i < shard_count; i++) {
+            if (items[i + 1].revents & ZMQ_POLLIN) {
+                for (int k = 0; k < SHARD_BATCH; k++) {
+                    if (!forward_reply(shards, shard_count, i, socket)) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (items[0].revents & ZMQ_POLLIN) {
+            for (int k = 0; k < SHARD_BATCH; k++) {
+                int result = dispatch_request(shards, shard_count, socket);
+                if (result < 0) {
+                    rc = 1;
+                }
+                if (result <= 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    running = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(shards[i].thread, NULL);
+    }
+    for (int i = 0; i < shard_count; i++) {
+        if (shards[i].pipe) {
+            zmq_close(shards[i].pipe);
+        }
+        free(shards[i].table);
+    }
+    free(shards);
+    free(items);
+    return rc;
+}
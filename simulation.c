@@ -0,0 +1,207 @@
+#include "simulation.h"
+#include "candidates.h"
+#include "prng.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define SIM_MAX_THREADS 256
+#define SIM_CHUNK 256   // игр за один захват работы
+
+// Очередь работы потока: диапазон [next, end) номеров игр.
+// Владелец и "воры" забирают порции одним atomic_fetch_add, поэтому
+// перебор за end безопасен - такая порция просто пустая.
+typedef struct {
+    _Atomic long next;
+    long end;
+    char pad[64 - sizeof(long) * 2];
+} WorkQueue;
+
+typedef struct {
+    int id;
+    int threads;
+    SimStrategy strategy;
+    WorkQueue *queues;
+    SimResult result;
+} SimWorker;
+
+// Захватывает порцию игр из очереди; 0 - очередь пуста
+static long take_chunk(WorkQueue *queue, long *start) {
+    if (atomic_load_explicit(&queue->next, memory_order_relaxed) >= queue->end) {
+        return 0;
+    }
+
+    long begin = atomic_fetch_add_explicit(&queue->next, SIM_CHUNK, memory_order_relaxed);
+    if (begin >= queue->end) {
+        return 0;
+    }
+
+    *start = begin;
+    return (begin + SIM_CHUNK > queue->end) ? queue->end - begin : SIM_CHUNK;
+}
+
+// Играет одну партию, возвращает число попыток (0 - не угадано)
+static int play_one_game(SimStrategy strategy, Prng *rng, CandidateSet *candidates) {
+    int secret[SECRET_LENGTH];
+
+    generate_secret(secret);
+    candidate_set_reset(candidates);
+
+    for (int attempt = 1; attempt <= MAX_ATTEMPTS && candidates->count > 0; attempt++) {
+        int pick = (strategy == STRATEGY_RANDOM) ? prng_below(rng, candidates->count) : 0;
+        int guess[SECRET_LENGTH];
+        candidate_set_nth(candidates, pick, guess);
+
+        int bulls, cows;
+        calculate_bulls_cows(secret, guess, &bulls, &cows);
+        if (bulls == SECRET_LENGTH) {
+            return attempt;
+        }
+
+        // Оставляем только числа, дающие тот же ответ на эту попытку
+        candidate_set_filter(candidates, guess, bulls, cows);
+    }
+
+    return 0;
+}
+
+static void* simulation_worker(void *arg) {
+    SimWorker *worker = (SimWorker*)arg;
+    CandidateSet candidates;
+    long start, n;
+    Prng *rng = prng_local();
+
+    // Сначала своя очередь, затем забираем работу у остальных
+    for (int k = 0; k < worker->threads; k++) {
+        WorkQueue *queue = &worker->queues[(worker->id + k) % worker->threads];
+
+        while ((n = take_chunk(queue, &start)) > 0) {
+            for (long g = 0; g < n; g++) {
+                // Поток чисел привязан к номеру игры, а не к потоку: с --seed
+                // итог не зависит от числа потоков и от кражи порций.
+                // Тот же генератор выбирает секреты в generate_secret.
+                prng_seed_local(start + g);
+                int attempts = play_one_game(worker->strategy, rng, &candidates);
+
+                worker->result.games++;
+                if (attempts == 0) {
+                    worker->result.failed++;
+                    continue;
+                }
+                worker->result.total_attempts += attempts;
+                worker->result.histogram[attempts]++;
+                if (attempts > worker->result.max_attempts) {
+                    worker->result.max_attempts = attempts;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int parse_strategy(const char *name, SimStrategy *strategy) {
+    if (strcmp(name, "random") == 0) {
+        *strategy = STRATEGY_RANDOM;
+        return 1;
+    }
+    if (strcmp(name, "first") == 0) {
+        *strategy = STRATEGY_FIRST;
+        return 1;
+    }
+    return 0;
+}
+
+int run_simulation(SimStrategy strategy, long games, int threads, SimResult *result) {
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) threads = 1;
+    if (threads > SIM_MAX_THREADS) threads = SIM_MAX_THREADS;
+
+    WorkQueue *queues = calloc(threads, sizeof(WorkQueue));
+    SimWorker *workers = calloc(threads, sizeof(SimWorker));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    if (!queues || !workers || !tids) {
+        free(queues);
+        free(workers);
+        free(tids);
+        return -1;
+    }
+
+    // Делим игры поровну, дисбаланс выравнивается кражей порций
+    for (int i = 0; i < threads; i++) {
+        atomic_init(&queues[i].next, games * i / threads);
+        queues[i].end = games * (i + 1) / threads;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        workers[i].id = i;
+        workers[i].threads = threads;
+        workers[i].strategy = strategy;
+        workers[i].queues = queues;
+        if (pthread_create(&tids[i], NULL, simulation_worker, &workers[i]) != 0) {
+            printf("Ошибка создания потока симуляции\n");
+            break;
+        }
+        started++;
+    }
+
+    // Если часть потоков не стартовала, их очереди разберут остальные
+    if (started == 0) {
+        simulation_worker(&workers[0]);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    memset(result, 0, sizeof(SimResult));
+    for (int i = 0; i < threads; i++) {
+        SimResult *r = &workers[i].result;
+        result->games += r->games;
+        result->total_attempts += r->total_attempts;
+        result->failed += r->failed;
+        if (r->max_attempts > result->max_attempts) {
+            result->max_attempts = r->max_attempts;
+        }
+        for (int a = 0; a <= MAX_ATTEMPTS; a++) {
+            result->histogram[a] += r->histogram[a];
+        }
+    }
+    result->elapsed = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    free(queues);
+    free(workers);
+    free(tids);
+    return threads;
+}
+
+void print_simulation_result(SimStrategy strategy, int threads, SimResult *result) {
+    long won = result->games - result->failed;
+
+    printf("Стратегия: %s, потоков: %d\n",
+           strategy == STRATEGY_RANDOM ? "random" : "first", threads);
+    printf("Сыграно игр: %ld за %.3f с (%.0f игр/мин)\n",
+           result->games, result->elapsed,
+           result->elapsed > 0 ? result->games * 60.0 / result->elapsed : 0.0);
+
+    if (won > 0) {
+        printf("Среднее число попыток: %.4f, максимум: %d\n",
+               (double)result->total_attempts / won, result->max_attempts);
+    }
+    if (result->failed > 0) {
+        printf("Не угадано за %d попыток: %ld\n", MAX_ATTEMPTS, result->failed);
+    }
+
+    printf("\nРаспределение попыток:\n");
+    for (int a = 1; a <= result->max_attempts; a++) {
+        printf("  %3d: %10ld (%6.2f%%)\n", a, result->histogram[a],
+               result->games > 0 ? result->histogram[a] * 100.0 / result->games : 0.0);
+    }
+}
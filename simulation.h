@@ -0,0 +1,26 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "common.h"
+
+// Стратегии бота для серверной симуляции
+typedef enum {
+    STRATEGY_RANDOM,    // случайное число из ещё возможных
+    STRATEGY_FIRST      // первое по порядку из ещё возможных
+} SimStrategy;
+
+// Итоги симуляции
+typedef struct {
+    long games;
+    long total_attempts;
+    int max_attempts;
+    long failed;                          // игры, не уложившиеся в MAX_ATTEMPTS
+    long histogram[MAX_ATTEMPTS + 1];     // число игр по количеству попыток
+    double elapsed;                       // секунды
+} SimResult;
+
+int parse_strategy(const char *name, SimStrategy *strategy);
+int run_simulation(SimStrategy strategy, long games, int threads, SimResult *result);
+void print_simulation_result(SimStrategy strategy, int threads, SimResult *result);
+
+#endif // SIMULATION_H
@@ -0,0 +1,103 @@
+#include "timer_wheel.h"
+
+static void link_node(TimerWheel *wheel, int id, int level, int slot) {
+    TimerNode *node = &wheel->nodes[id];
+
+    node->level = level;
+    node->slot = slot;
+    node->prev = TIMER_NONE;
+    node->next = wheel->heads[level][slot];
+    if (node->next != TIMER_NONE) {
+        wheel->nodes[node->next].prev = id;
+    }
+    wheel->heads[level][slot] = id;
+}
+
+static void unlink_node(TimerWheel *wheel, int id) {
+    TimerNode *node = &wheel->nodes[id];
+
+    if (node->prev != TIMER_NONE) {
+        wheel->nodes[node->prev].next = node->next;
+    } else {
+        wheel->heads[node->level][node->slot] = node->next;
+    }
+    if (node->next != TIMER_NONE) {
+        wheel->nodes[node->next].prev = node->prev;
+    }
+    node->level = TIMER_NONE;
+}
+
+// Раскладывает таймер по уровню в зависимости от оставшегося времени
+static void place_node(TimerWheel *wheel, int id) {
+    uint32_t expires = wheel->nodes[id].expires;
+    uint32_t delay = expires - wheel->now;
+
+    if (delay < WHEEL_SLOTS) {
+        link_node(wheel, id, 0, expires & (WHEEL_SLOTS - 1));
+    } else {
+        link_node(wheel, id, 1, (expires >> WHEEL_BITS) & (WHEEL_SLOTS - 1));
+    }
+}
+
+void timer_wheel_init(TimerWheel *wheel, uint32_t now) {
+    wheel->now = now;
+    for (int level = 0; level < 2; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            wheel->heads[level][slot] = TIMER_NONE;
+        }
+    }
+    for (int id = 0; id < TIMER_COUNT; id++) {
+        wheel->nodes[id].level = TIMER_NONE;
+    }
+}
+
+// Ставит или переставляет таймер; срок дальше WHEEL_MAX_DELAY обрезается
+void timer_schedule(TimerWheel *wheel, int id, uint32_t expires) {
+    if (wheel->nodes[id].level != TIMER_NONE) {
+        unlink_node(wheel, id);
+    }
+
+    uint32_t delay = expires - wheel->now;
+    if ((int32_t)delay <= 0) {
+        expires = wheel->now + 1;
+    } else if (delay > WHEEL_MAX_DELAY) {
+        expires = wheel->now + WHEEL_MAX_DELAY;
+    }
+
+    wheel->nodes[id].expires = expires;
+    place_node(wheel, id);
+}
+
+void timer_cancel(TimerWheel *wheel, int id) {
+    if (wheel->nodes[id].level != TIMER_NONE) {
+        unlink_node(wheel, id);
+    }
+}
+
+// Продвигает колесо до момента now, вызывая callback для истёкших таймеров.
+// Внутри callback можно ставить и отменять любые таймеры.
+void timer_advance(TimerWheel *wheel, uint32_t now, TimerCallback callback, void *arg) {
+    while ((int32_t)(now - wheel->now) > 0) {
+        wheel->now++;
+
+        // Начало нового круга: переносим таймеры второго уровня на первый
+        if ((wheel->now & (WHEEL_SLOTS - 1)) == 0) {
+            int slot = (wheel->now >> WHEEL_BITS) & (WHEEL_SLOTS - 1);
+            int id = wheel->heads[1][slot];
+            wheel->heads[1][slot] = TIMER_NONE;
+            while (id != TIMER_NONE) {
+                int next = wheel->nodes[id].next;
+                wheel->nodes[id].level = TIMER_NONE;
+                place_node(wheel, id);
+                id = next;
+            }
+        }
+
+        int slot = wheel->now & (WHEEL_SLOTS - 1);
+        int id;
+        while ((id = wheel->heads[0][slot]) != TIMER_NONE) {
+            unlink_node(wheel, id);
+            callback(id, arg);
+        }
+    }
+}
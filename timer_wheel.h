@@ -0,0 +1,39 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "common.h"
+
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MAX_DELAY (WHEEL_SLOTS * WHEEL_SLOTS - 1)   // в тиках
+
+// Таймер на каждую игру и на каждый слот игрока в ней
+#define TIMER_COUNT (MAX_GAMES * (MAX_PLAYERS + 1))
+#define TIMER_NONE -1
+
+typedef struct {
+    int prev;
+    int next;
+    int level;          // TIMER_NONE - таймер не запущен
+    int slot;
+    uint32_t expires;   // тик срабатывания
+} TimerNode;
+
+// Двухуровневое колесо таймеров: 256 слотов по одному тику и 256 слотов
+// по 256 тиков. Постановка, отмена и срабатывание - O(1). Таймеры
+// адресуются индексами, без указателей, поэтому колесо можно хранить
+// в разделяемой памяти.
+typedef struct {
+    uint32_t now;
+    int heads[2][WHEEL_SLOTS];
+    TimerNode nodes[TIMER_COUNT];
+} TimerWheel;
+
+typedef void (*TimerCallback)(int id, void *arg);
+
+void timer_wheel_init(TimerWheel *wheel, uint32_t now);
+void timer_schedule(TimerWheel *wheel, int id, uint32_t expires);
+void timer_cancel(TimerWheel *wheel, int id);
+void timer_advance(TimerWheel *wheel, uint32_t now, TimerCallback callback, void *arg);
+
+#endif // TIMER_WHEEL_H